@@ -0,0 +1,145 @@
+/* Writes a localisation-style file of <rows> rows to <path>, with the odd
+ * comment, blank line and CRLF line ending, then times splitting it into rows
+ * and fields with csv_open() and reading every field of every row. Mapping
+ * the file and counting the same delimiters a byte at a time is timed
+ * alongside for reference.
+ *
+ * Usage: bench_csv <path> [rows] [runs] */
+
+#include "csv.h"
+#include "random.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static void write_text(FILE* file, uint32_t length) {
+	static char const letters[] = "abcdefghijklmnopqrstuvwxyz  ,.";
+	uint32_t i;
+	for (i = 0; i < length; i++) {
+		fputc(letters[random_below(sizeof(letters) - 1)], file);
+	}
+}
+
+static void write_file(char const* path, unsigned long rows) {
+	unsigned long row;
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	fputs("CODE;ENGLISH;FRENCH;GERMAN;POLISH;SPANISH;ITALIAN;SWEDISH;"
+	      "CZECH;HUNGARIAN;DUTCH;PORTUGUESE;RUSSIAN;FINNISH;x\n", file);
+	for (row = 0; row < rows; row++) {
+		uint32_t kind = random_below(64);
+		int column;
+		if (kind == 0) {
+			fputs("# ", file);
+			write_text(file, 8 + random_below(32));
+			fputc('\n', file);
+			continue;
+		} else if (kind == 1) {
+			fputc('\n', file);
+			continue;
+		}
+		fprintf(file, "KEY_%lu", row);
+		/* English and a few translations, the rest left empty. */
+		for (column = 0; column < 13; column++) {
+			fputc(';', file);
+			if (column < 4 || random_below(4) == 0) {
+				write_text(file, 4 + random_below(40));
+			}
+		}
+		fputs(kind == 2 ? ";x\r\n" : ";x\n", file);
+	}
+	if (fclose(file) != 0) {
+		fprintf(stderr, "Failed to write %s: %s\n", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+static double seconds_since(uint64_t start) {
+	return (double) (SDL_GetPerformanceCounter() - start)
+	       / (double) SDL_GetPerformanceFrequency();
+}
+
+static void report(char const* what, size_t bytes, size_t rows,
+                   double best, double total, int runs) {
+	double megabytes = (double) bytes / (1024 * 1024);
+	printf("%-12s best %8.2f ms  %8.1f MB/s  %8.2f Mrows/s  mean %8.1f MB/s\n",
+	       what, best * 1000, megabytes / best, (double) rows / best / 1e6,
+	       megabytes * runs / total);
+}
+
+int main(int argc, char** argv) {
+	unsigned long rows = 1000000;
+	int runs = 5;
+	int run;
+	size_t bytes = 0, row_count = 0;
+	double best[3] = {0, 0, 0}, total[3] = {0, 0, 0};
+	unsigned long checksum = 0;
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "Usage: %s <path> [rows] [runs]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc > 2) rows = strtoul(argv[2], NULL, 10);
+	if (argc > 3) runs = atoi(argv[3]);
+	if (runs < 1) runs = 1;
+	write_file(argv[1], rows);
+
+	for (run = 0; run < runs; run++) {
+		double seconds[3];
+		uint64_t start;
+		struct mapped_file file;
+		struct csv_file* csv;
+		char const* cur;
+		size_t row, column, delimiters = 0;
+
+		/* Reference: looking at every byte once. */
+		start = SDL_GetPerformanceCounter();
+		if (!map_file(argv[1], &file)) {
+			fprintf(stderr, "Failed to open %s: %s\n", argv[1], strerror(errno));
+			return EXIT_FAILURE;
+		}
+		for (cur = file.data; cur != file.data + file.size; cur++) {
+			delimiters += *cur == ';' || *cur == '\n' || *cur == '#';
+		}
+		unmap_file(&file);
+		seconds[0] = seconds_since(start);
+
+		start = SDL_GetPerformanceCounter();
+		csv = csv_open(argv[1]);
+		if (csv == NULL) return EXIT_FAILURE;
+		seconds[1] = seconds_since(start);
+
+		start = SDL_GetPerformanceCounter();
+		for (row = 0; row < csv->row_count; row++) {
+			size_t width = csv_row_width(csv, row);
+			for (column = 0; column < width; column++) {
+				struct csv_field field;
+				csv_get_field(csv, row, column, &field);
+				checksum += field.length;
+			}
+		}
+		seconds[2] = seconds_since(start);
+		bytes = csv->file.size;
+		row_count = csv->row_count;
+		csv_close(csv);
+		checksum += delimiters;
+
+		for (column = 0; column < 3; column++) {
+			if (run == 0 || seconds[column] < best[column]) {
+				best[column] = seconds[column];
+			}
+			total[column] += seconds[column];
+		}
+	}
+
+	printf("%.2f MB, %lu rows (checksum %lu)\n",
+	       (double) bytes / (1024 * 1024), (unsigned long) row_count, checksum);
+	report("byte loop", bytes, row_count, best[0], total[0], runs);
+	report("csv_open", bytes, row_count, best[1], total[1], runs);
+	report("fields", bytes, row_count, best[2], total[2], runs);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+/* Fills a province map of <width> by <height> pixels, the size of the game's
+ * own by default, with <provinces> provinces of wavy outlines and some sea,
+ * then times build_province_geometry() over it. Adding up every pixel on one
+ * thread is timed alongside for reference, and the two must agree.
+ *
+ * Usage: bench_geometry [width] [height] [provinces] [runs] */
+
+#include "province_geometry.h"
+#include "random.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Provinces are the cells of a grid with borders bent by a few sines, and one
+ * in eight of them is sea. */
+static void fill_map(struct province_map* map, size_t provinces) {
+	uint32_t columns = (uint32_t) ceil(sqrt((double) provinces * map->width / map->height));
+	uint32_t rows = (uint32_t) ((provinces + columns - 1) / columns);
+	double cell_width = (double) map->width / columns;
+	double cell_height = (double) map->height / rows;
+	double phase = (double) random_below(1000);
+	uint16_t* cells = malloc((size_t) columns * rows * sizeof(uint16_t));
+	uint32_t x, y, i;
+	if (cells == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the map.\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < columns * rows; i++) {
+		cells[i] = i >= provinces || random_below(8) == 0 ? PROVINCE_NONE : (uint16_t) i;
+	}
+	for (y = 0; y < map->height; y++) {
+		for (x = 0; x < map->width; x++) {
+			double bent_x = x + cell_width * 0.3 * sin(y * 0.05 + phase);
+			double bent_y = y + cell_height * 0.3 * sin(x * 0.04 + phase);
+			long column = (long) (bent_x / cell_width);
+			long row = (long) (bent_y / cell_height);
+			if (column < 0) column = 0;
+			if (column >= (long) columns) column = columns - 1;
+			if (row < 0) row = 0;
+			if (row >= (long) rows) row = rows - 1;
+			map->pixels[(size_t) y * map->width + x] = cells[row * columns + column];
+		}
+	}
+	free(cells);
+}
+
+/* Reference: every pixel on its own, on one thread. */
+static void sum_pixels(struct province_map const* map, size_t provinces,
+                       uint64_t* sum_x, uint64_t* sum_y, uint32_t* pixels,
+                       uint32_t* min_x, uint32_t* max_x) {
+	uint32_t x, y;
+	memset(sum_x, 0, provinces * sizeof(uint64_t));
+	memset(sum_y, 0, provinces * sizeof(uint64_t));
+	memset(pixels, 0, provinces * sizeof(uint32_t));
+	memset(min_x, 0xff, provinces * sizeof(uint32_t));
+	memset(max_x, 0, provinces * sizeof(uint32_t));
+	for (y = 0; y < map->height; y++) {
+		for (x = 0; x < map->width; x++) {
+			uint16_t province = map->pixels[(size_t) y * map->width + x];
+			if (province == PROVINCE_NONE) continue;
+			sum_x[province] += x;
+			sum_y[province] += y;
+			pixels[province] += 1;
+			if (x < min_x[province]) min_x[province] = x;
+			if (x > max_x[province]) max_x[province] = x;
+		}
+	}
+}
+
+static double seconds_since(uint64_t start) {
+	return (double) (SDL_GetPerformanceCounter() - start)
+	       / (double) SDL_GetPerformanceFrequency();
+}
+
+static void report(char const* what, size_t pixels, double best, double total, int runs) {
+	printf("%-10s best %8.2f ms  %8.1f Mpixels/s  mean %8.2f ms\n",
+	       what, best * 1000, (double) pixels / best / 1e6, total * 1000 / runs);
+}
+
+int main(int argc, char** argv) {
+	struct province_map map;
+	size_t provinces = 3248;
+	size_t size, i;
+	int runs = 5;
+	int run;
+	double best[2] = {0, 0}, total[2] = {0, 0};
+	uint64_t* sum_x;
+	uint64_t* sum_y;
+	uint32_t* pixels;
+	uint32_t* min_x;
+	uint32_t* max_x;
+	size_t mismatches = 0;
+
+	map.width = 5616;
+	map.height = 2160;
+	if (argc > 5) {
+		fprintf(stderr, "Usage: %s [width] [height] [provinces] [runs]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc > 1) map.width = (uint32_t) strtoul(argv[1], NULL, 10);
+	if (argc > 2) map.height = (uint32_t) strtoul(argv[2], NULL, 10);
+	if (argc > 3) provinces = strtoul(argv[3], NULL, 10);
+	if (argc > 4) runs = atoi(argv[4]);
+	if (runs < 1) runs = 1;
+	if (map.width == 0 || map.height == 0 || provinces == 0 || provinces >= PROVINCE_NONE) {
+		fprintf(stderr, "Invalid map size or province count.\n");
+		return EXIT_FAILURE;
+	}
+	size = (size_t) map.width * map.height;
+	map.pixels = malloc(size * sizeof(uint16_t));
+	sum_x = malloc(provinces * sizeof(uint64_t));
+	sum_y = malloc(provinces * sizeof(uint64_t));
+	pixels = malloc(provinces * sizeof(uint32_t));
+	min_x = malloc(provinces * sizeof(uint32_t));
+	max_x = malloc(provinces * sizeof(uint32_t));
+	if (map.pixels == NULL || sum_x == NULL || sum_y == NULL
+	    || pixels == NULL || min_x == NULL || max_x == NULL) {
+		fprintf(stderr, "Failed to allocate memory.\n");
+		return EXIT_FAILURE;
+	}
+	fill_map(&map, provinces);
+
+	for (run = 0; run < runs; run++) {
+		struct province_geometry geometry;
+		double seconds[2];
+		uint64_t start;
+		int column;
+
+		start = SDL_GetPerformanceCounter();
+		sum_pixels(&map, provinces, sum_x, sum_y, pixels, min_x, max_x);
+		seconds[0] = seconds_since(start);
+
+		start = SDL_GetPerformanceCounter();
+		if (!build_province_geometry(&map, provinces, &geometry)) return EXIT_FAILURE;
+		seconds[1] = seconds_since(start);
+
+		for (i = 0; i < provinces; i++) {
+			float center_x = pixels[i] == 0 ? 0.0f
+			                 : (float) ((double) sum_x[i] / pixels[i] + 0.5);
+			float center_y = pixels[i] == 0 ? 0.0f
+			                 : (float) ((double) sum_y[i] / pixels[i] + 0.5);
+			if (geometry.pixels[i] != pixels[i]
+			    || (pixels[i] != 0 && (geometry.min_x[i] != min_x[i]
+			                           || geometry.max_x[i] != max_x[i]))
+			    || geometry.center_x[i] != center_x || geometry.center_y[i] != center_y) {
+				mismatches++;
+			}
+		}
+		free_province_geometry(&geometry);
+
+		for (column = 0; column < 2; column++) {
+			if (run == 0 || seconds[column] < best[column]) {
+				best[column] = seconds[column];
+			}
+			total[column] += seconds[column];
+		}
+	}
+
+	printf("%ux%u pixels, %lu provinces, %d CPUs\n", map.width, map.height,
+	       (unsigned long) provinces, SDL_GetCPUCount());
+	report("pixels", size, best[0], total[0], runs);
+	report("geometry", size, best[1], total[1], runs);
+	if (mismatches != 0) {
+		fprintf(stderr, "%lu provinces differ from the reference.\n", (unsigned long) mismatches);
+		return EXIT_FAILURE;
+	}
+	free(map.pixels);
+	free(sum_x);
+	free(sum_y);
+	free(pixels);
+	free(min_x);
+	free(max_x);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,282 @@
+/* Times parse() over every file in <directory>/interface and parse_font_desc()
+ * over every .fnt in <directory>/gfx/fonts, as written by gen_interface, and
+ * reports throughput, heap allocations per MB and peak RSS. Each run parses
+ * into a fresh arena; interned strings are kept between runs as in the game.
+ * The interface files are then parsed again by 1, 2, 4... up to [threads]
+ * threads, the number of CPUs by default, each taking the next file and
+ * parsing into its own arena as the worker pool does.
+ *
+ * Usage: bench_parse <directory> [runs] [threads] */
+
+#include "parse.h"
+#include "fs.h"
+#include "arena.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/* Allocations are counted where the linker can wrap malloc, see
+ * CMakeLists.txt. Allocations made inside the C library, by strdup for one,
+ * are not seen. */
+#ifdef BENCH_COUNT_ALLOCATIONS
+static unsigned long allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+	allocations += 1;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+	allocations += 1;
+	return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+	allocations += 1;
+	return __real_realloc(ptr, size);
+}
+#endif
+
+struct file_set {
+	char** paths;
+	size_t count;
+	size_t bytes;
+};
+
+static void add_files(struct file_set* set, char const* directory, char const* ext) {
+	DIR* dir = opendir(directory);
+	struct dirent* entry;
+	if (dir == NULL) {
+		fprintf(stderr, "Failed to open %s: %s\n", directory, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		struct stat st;
+		size_t length = strlen(directory) + 1 + strlen(entry->d_name) + 1;
+		char* path;
+		if (ext != NULL ? !has_ext(entry->d_name, ext)
+		    : !(has_ext(entry->d_name, ".gfx") || has_ext(entry->d_name, ".gui"))) {
+			continue;
+		}
+		path = malloc(length);
+		set->paths = realloc(set->paths, (set->count + 1) * sizeof(char*));
+		if (path == NULL || set->paths == NULL) {
+			fprintf(stderr, "Failed to allocate: %s\n", strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		sprintf(path, "%s/%s", directory, entry->d_name);
+		if (stat(path, &st) != 0) {
+			fprintf(stderr, "Failed to stat %s: %s\n", path, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		set->paths[set->count++] = path;
+		set->bytes += (size_t) st.st_size;
+	}
+	closedir(dir);
+}
+
+struct parallel_parse {
+	struct file_set const* files;
+	SDL_atomic_t next;
+};
+
+static int parse_files(void* data) {
+	struct parallel_parse* job = data;
+	struct arena arena = {0};
+	int i;
+	while ((i = SDL_AtomicAdd(&job->next, 1)) < (int) job->files->count) {
+		struct sprite_list sprites = {NULL, 0};
+		struct ui_widget_list widgets = {NULL, 0};
+		struct bitmap_font_list bitmap_fonts = {NULL, 0};
+		struct font_list font_defs = {NULL, 0};
+		parse(job->files->paths[i], &arena, &sprites, &widgets,
+		      &bitmap_fonts, &font_defs);
+	}
+	arena_free(&arena);
+	return 0;
+}
+
+/* Doubles the thread count, ending on `max_threads` even if it is not a
+ * power of two. */
+static int next_thread_count(int threads, int max_threads) {
+	if (threads < max_threads && threads * 2 > max_threads) return max_threads;
+	return threads * 2;
+}
+
+static double seconds_since(uint64_t start) {
+	return (double) (SDL_GetPerformanceCounter() - start)
+	       / (double) SDL_GetPerformanceFrequency();
+}
+
+static void report(char const* what, size_t bytes, double best, double total,
+                   unsigned long allocated, int runs) {
+	double megabytes = (double) bytes / (1024 * 1024);
+	printf("%-16s %8.2f MB  best %8.2f ms  %8.1f MB/s  mean %8.1f MB/s",
+	       what, megabytes, best * 1000, megabytes / best,
+	       megabytes * runs / total);
+#ifdef BENCH_COUNT_ALLOCATIONS
+	printf("  %8.1f allocations/MB", (double) allocated / (megabytes * runs));
+#else
+	(void) allocated;
+#endif
+	printf("\n");
+}
+
+int main(int argc, char** argv) {
+	struct file_set interface = {NULL, 0, 0};
+	struct file_set fonts = {NULL, 0, 0};
+	char path[4096];
+	double best = 0, total = 0;
+	unsigned long allocated = 0;
+	int runs = 5;
+	int max_threads = SDL_GetCPUCount();
+	double one_thread = 0;
+	int threads;
+	int run;
+	size_t i;
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "Usage: %s <directory> [runs] [threads]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc > 2) runs = atoi(argv[2]);
+	if (runs < 1) runs = 1;
+	if (argc > 3) max_threads = atoi(argv[3]);
+	if (max_threads < 1) max_threads = 1;
+	if (strlen(argv[1]) > sizeof(path) - 16) {
+		fprintf(stderr, "Path too long: %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	sprintf(path, "%s/interface", argv[1]);
+	add_files(&interface, path, NULL);
+	sprintf(path, "%s/gfx/fonts", argv[1]);
+	add_files(&fonts, path, ".fnt");
+
+	for (run = 0; run < runs; run++) {
+		struct arena arena = {0};
+		size_t counts[4] = {0, 0, 0, 0};
+		uint64_t start;
+		double seconds;
+#ifdef BENCH_COUNT_ALLOCATIONS
+		unsigned long before = allocations;
+#endif
+		start = SDL_GetPerformanceCounter();
+		/* Every file gets its own lists, as in load_interface, since
+		 * parse() copies the lists it appends to. */
+		for (i = 0; i < interface.count; i++) {
+			struct sprite_list sprites = {NULL, 0};
+			struct ui_widget_list widgets = {NULL, 0};
+			struct bitmap_font_list bitmap_fonts = {NULL, 0};
+			struct font_list font_defs = {NULL, 0};
+			parse(interface.paths[i], &arena, &sprites, &widgets,
+			      &bitmap_fonts, &font_defs);
+			counts[0] += sprites.count;
+			counts[1] += widgets.count;
+			counts[2] += bitmap_fonts.count;
+			counts[3] += font_defs.count;
+		}
+		seconds = seconds_since(start);
+#ifdef BENCH_COUNT_ALLOCATIONS
+		allocated += allocations - before;
+#endif
+		if (run == 0 || seconds < best) best = seconds;
+		total += seconds;
+		if (run == 0) {
+			printf("%lu files: %lu sprites, %lu top-level widgets, "
+			       "%lu bitmap fonts, %lu fonts\n",
+			       (unsigned long) interface.count,
+			       (unsigned long) counts[0], (unsigned long) counts[1],
+			       (unsigned long) counts[2], (unsigned long) counts[3]);
+		}
+		arena_free(&arena);
+	}
+	report("parse", interface.bytes, best, total, allocated, runs);
+
+	best = 0;
+	total = 0;
+	allocated = 0;
+	for (run = 0; run < runs && fonts.count > 0; run++) {
+		uint64_t start;
+		double seconds;
+#ifdef BENCH_COUNT_ALLOCATIONS
+		unsigned long before = allocations;
+#endif
+		start = SDL_GetPerformanceCounter();
+		for (i = 0; i < fonts.count; i++) {
+			struct font_desc desc;
+			parse_font_desc(fonts.paths[i], &desc);
+			free_font_desc(&desc);
+		}
+		seconds = seconds_since(start);
+#ifdef BENCH_COUNT_ALLOCATIONS
+		allocated += allocations - before;
+#endif
+		if (run == 0 || seconds < best) best = seconds;
+		total += seconds;
+	}
+	if (fonts.count > 0) {
+		report("parse_font_desc", fonts.bytes, best, total, allocated, runs);
+	}
+
+	for (threads = 1; threads <= max_threads; threads = next_thread_count(threads, max_threads)) {
+		SDL_Thread** handles = malloc((size_t) threads * sizeof(SDL_Thread*));
+		if (handles == NULL) {
+			fprintf(stderr, "Failed to allocate: %s\n", strerror(errno));
+			return EXIT_FAILURE;
+		}
+		best = 0;
+		for (run = 0; run < runs; run++) {
+			struct parallel_parse job;
+			uint64_t start;
+			double seconds;
+			int t;
+			job.files = &interface;
+			SDL_AtomicSet(&job.next, 0);
+			start = SDL_GetPerformanceCounter();
+			for (t = 0; t < threads; t++) {
+				if ((handles[t] = SDL_CreateThread(parse_files, "parse", &job)) == NULL) {
+					fprintf(stderr, "Failed to create thread: %s\n", SDL_GetError());
+					return EXIT_FAILURE;
+				}
+			}
+			for (t = 0; t < threads; t++) {
+				SDL_WaitThread(handles[t], NULL);
+			}
+			seconds = seconds_since(start);
+			if (run == 0 || seconds < best) best = seconds;
+		}
+		free(handles);
+		if (threads == 1) one_thread = best;
+		printf("parse %3d threads  best %8.2f ms  %8.1f MB/s  speedup %5.2f\n",
+		       threads, best * 1000, (double) interface.bytes / (1024 * 1024) / best,
+		       one_thread / best);
+	}
+
+#ifndef _WIN32
+	{
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) == 0) {
+			/* Kilobytes on Linux, bytes on macOS. */
+#ifdef __APPLE__
+			usage.ru_maxrss /= 1024;
+#endif
+			printf("peak RSS %.1f MB\n", (double) usage.ru_maxrss / 1024);
+		}
+	}
+#endif
+
+	for (i = 0; i < interface.count; i++) free(interface.paths[i]);
+	for (i = 0; i < fonts.count; i++) free(fonts.paths[i]);
+	free(interface.paths);
+	free(fonts.paths);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/* Checks that the parser reads number literals exactly as strtol and strtod
+ * do. Every integer literal and decimal was converted by them before the
+ * parser learned to convert the common spellings itself, and they still
+ * convert the rest. For <count> random spellings, and every decimal of up to
+ * 6 digits with the point anywhere, it compares:
+ *
+ *   - the in-place conversion, whenever it takes a spelling, with strtol and
+ *     strtod on a NUL-terminated copy, bit for bit, and it must only take
+ *     spellings those accept whole;
+ *   - parse_int_literal and parse_float_literal on a literal in memory with
+ *     the C library, for the non-empty spellings that parse without a
+ *     syntax error, including where the cursor ends up.
+ *
+ * Spellings with bytes the parser does not take as part of a number, '.' in
+ * an integer, are not checked: they never reach the conversions.
+ *
+ * Exits with failure on any difference.
+ *
+ * Usage: check_numbers [count] [seed] */
+
+/* The conversions are static, so parse.c is part of this program. */
+#include "parse.c"
+#include "random.h"
+
+static unsigned long checked;
+static unsigned long fast;
+static unsigned long mismatches;
+
+static void report_mismatch(char const* what, char const* literal) {
+	if (mismatches < 20) {
+		fprintf(stderr, "%s differs for '%s'\n", what, literal);
+	}
+	mismatches++;
+}
+
+/* A source over `literal` followed by " }", as in a definition. */
+static void open_literal(struct source* src, char* buffer, char const* literal) {
+	strcpy(buffer, literal);
+	strcat(buffer, " }");
+	memset(src, 0, sizeof(struct source));
+	src->name = "literal";
+	src->file.data = buffer;
+	src->file.size = strlen(buffer);
+	src->cur = buffer;
+	src->end = buffer + src->file.size;
+	src->loc.lineno = 1;
+	src->loc.colno = 1;
+}
+
+static void check_int(char const* literal) {
+	size_t length = strlen(literal);
+	char buffer[128];
+	struct source src;
+	char* endptr;
+	long expected;
+	bool accepted;
+	bool whole;
+	int64_t value;
+	errno = 0;
+	expected = strtol(literal, &endptr, 10);
+	accepted = *endptr == '\0' && expected != LONG_MIN && expected != LONG_MAX;
+	whole = skip_number(literal, literal + length, false) == literal + length;
+	checked++;
+	if (!whole) return;
+	if (convert_int(literal, literal + length, &value)) {
+		fast++;
+		if (!accepted || value != (int64_t) expected) {
+			report_mismatch("convert_int", literal);
+		}
+	}
+	if (accepted && length != 0) {
+		open_literal(&src, buffer, literal);
+		parse_int_literal(&src, &value);
+		if (value != (int64_t) expected || src.cur != buffer + length
+		    || src.loc.colno != length + 1) {
+			report_mismatch("parse_int_literal", literal);
+		}
+	}
+}
+
+static void check_float(char const* literal) {
+	size_t length = strlen(literal);
+	char buffer[128];
+	struct source src;
+	char* endptr;
+	double expected;
+	bool accepted;
+	bool whole;
+	double value;
+	errno = 0;
+	expected = strtod(literal, &endptr);
+	accepted = *endptr == '\0' && expected != HUGE_VAL;
+	whole = skip_number(literal, literal + length, true) == literal + length;
+	checked++;
+	if (!whole) return;
+	if (convert_float(literal, literal + length, &value)) {
+		fast++;
+		if (!accepted || memcmp(&value, &expected, sizeof(double)) != 0) {
+			report_mismatch("convert_float", literal);
+		}
+	}
+	if (accepted && length != 0) {
+		open_literal(&src, buffer, literal);
+		parse_float_literal(&src, &value);
+		if (memcmp(&value, &expected, sizeof(double)) != 0
+		    || src.cur != buffer + length || src.loc.colno != length + 1) {
+			report_mismatch("parse_float_literal", literal);
+		}
+	}
+}
+
+/* Mostly digits, with now and then a '-' or a '.' where it does not belong,
+ * and lengths around the limits of the in-place conversions. */
+static void random_literal(char* literal, bool fraction) {
+	size_t length = 0;
+	uint32_t digits = random_below(4) == 0 ? random_below(24) : 1 + random_below(10);
+	uint32_t point = fraction && random_below(8) != 0 ? random_below(digits + 1) : UINT32_MAX;
+	uint32_t i;
+	if (random_below(3) == 0) literal[length++] = '-';
+	for (i = 0; i <= digits; i++) {
+		if (i == point) literal[length++] = '.';
+		if (i == digits) break;
+		switch (random_below(64)) {
+		case 0:
+			literal[length++] = '-';
+			break;
+		case 1:
+			literal[length++] = fraction ? '.' : '-';
+			break;
+		default:
+			/* Runs of zeros and nines are where rounding goes wrong. */
+			literal[length++] = random_below(4) == 0 ? (random_below(2) ? '0' : '9')
+			                    : (char) ('0' + random_below(10));
+		}
+	}
+	literal[length] = '\0';
+}
+
+int main(int argc, char** argv) {
+	static char const* const edges[] = {
+		"", "-", ".", "-.", "0", "-0", "0.", ".0", "-0.0", "1.", ".5", "--1",
+		"1-", "1..2", "999999999", "-999999999", "1000000000", "-1000000000",
+		"2147483647", "-2147483648", "9223372036854775807",
+		"-9223372036854775808", "9223372036854775808", "0.1", "0.333",
+		"123456789012345", "1234567890123456", "0.000000000000001",
+		"0.0000000000000001", "999999999999999", "9999999999999999",
+		"4503599627370496.5", "9007199254740993", "0.30000000000000004"
+	};
+	unsigned long count = 1000000;
+	unsigned long i;
+	char literal[64];
+	if (argc > 3) {
+		fprintf(stderr, "Usage: %s [count] [seed]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc > 1) count = strtoul(argv[1], NULL, 10);
+	if (argc > 2) rng_state = strtoull(argv[2], NULL, 10);
+	if (rng_state == 0) rng_state = 1;
+
+	for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		check_int(edges[i]);
+		check_float(edges[i]);
+	}
+	for (i = 0; i < 1000000; i++) {
+		unsigned long digits = i < 10 ? 1 : i < 100 ? 2 : i < 1000 ? 3
+		                       : i < 10000 ? 4 : i < 100000 ? 5 : 6;
+		unsigned long point;
+		for (point = 0; point <= digits; point++) {
+			sprintf(literal, "%lu", i);
+			memmove(literal + point + 1, literal + point, digits - point + 1);
+			literal[point] = '.';
+			check_float(literal);
+		}
+	}
+	for (i = 0; i < count; i++) {
+		random_literal(literal, false);
+		check_int(literal);
+		random_literal(literal, true);
+		check_float(literal);
+	}
+
+	printf("%lu literals, %lu converted in place, %lu differences\n",
+	       checked, fast, mismatches);
+	return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
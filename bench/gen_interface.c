@@ -0,0 +1,363 @@
+/* Writes a synthetic interface/ directory for bench_parse: .gfx files with
+ * spriteTypes, bitmapfonts and fonts, .gui files with guiTypes whose windows
+ * nest up to a given depth, and a BMFont description in gfx/fonts/. The output
+ * only depends on the arguments, so runs on different trees are comparable.
+ *
+ * Usage: gen_interface <directory> [megabytes] [depth] [seed] */
+
+#include "random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <direct.h>
+#define make_directory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define make_directory(path) mkdir(path, 0755)
+#endif
+
+/* Each file holds about this many bytes. */
+#define FILE_SIZE ((size_t) 256 * 1024)
+
+/* A definition type and its properties as "name:kind" pairs, where the kind
+ * is one of
+ *   s string    i int         f float      b bool       v vec2
+ *   c rgb       h rgba hex    o orientation             a format
+ *   k click sound             l load type               C color codes */
+struct def_type {
+	char const* name;
+	char const* properties;
+};
+
+static struct def_type const sprite_types[] = {
+	{"spriteType", "texturefile:s noOfFrames:i allwaystransparent:b "
+	 "transparencecheck:b norefcount:b effectFile:s clicksound:k loadType:l"},
+	{"lineChartType", "size:v linewidth:i allwaystransparent:b"},
+	{"maskedShieldType", "textureFile1:s textureFile2:s effectFile:s "
+	 "allwaystransparent:b flipv:b"},
+	{"progressbarType", "color:c colortwo:c textureFile1:s textureFile2:s "
+	 "size:v effectFile:s allwaystransparent:b horizontal:b loadType:l"},
+	{"corneredTileSpriteType", "size:v texturefile:s bordersize:v loadType:l "
+	 "allwaystransparent:b"},
+	{"textSpriteType", "texturefile:s noOfFrames:i effectFile:s norefcount:b "
+	 "loadType:l clicksound:k"},
+	{"BarChartType", "size:v"},
+	{"PieChartType", "size:i"},
+	{"tileSpriteType", "texturefile:s effectFile:s loadType:l norefcount:b "
+	 "size:v"},
+	{"scrollingSprite", "textureFile1:s size:v effectFile:s step:i "
+	 "allwaystransparent:b"}
+};
+
+/* Containers come first, see write_widget. */
+#define CONTAINER_TYPES 3
+
+static struct def_type const widget_types[] = {
+	{"windowType", "background:s position:v size:v moveable:b dontRender:s "
+	 "horizontalBorder:s verticalBorder:s fullScreen:b orientation:o "
+	 "upsound:s downsound:s"},
+	{"scrollbarType", "slider:s track:s leftbutton:s rightbutton:s size:v "
+	 "position:v priority:i borderSize:v maxValue:f minValue:f stepSize:f "
+	 "startValue:f horizontal:b useRangeLimit:b rangeLimitMin:f "
+	 "rangeLimitMax:f rangeLimitMinIcon:s rangeLimitMaxIcon:s lockable:b"},
+	{"eu3dialogtype", "background:s position:v size:v moveable:b "
+	 "dontRender:s horizontalBorder:s verticalBorder:s fullScreen:b "
+	 "orientation:o"},
+	{"iconType", "spriteType:s position:v orientation:o frame:i "
+	 "buttonMesh:s rotation:f scale:f"},
+	{"guiButtonType", "position:v quadTextureSprite:s buttonText:s "
+	 "buttonFont:s shortcut:s clicksound:k orientation:o tooltip:s "
+	 "tooltipText:s delayedTooltipText:s spriteType:s parent:s size:v "
+	 "rotation:f format:a"},
+	{"textBoxType", "position:v font:s borderSize:v text:s maxWidth:i "
+	 "maxHeight:i format:a fixedsize:b textureFile:s orientation:o"},
+	{"instantTextBoxType", "position:v font:s borderSize:v text:s "
+	 "maxWidth:i maxHeight:i format:a fixedsize:b orientation:o "
+	 "textureFile:s allwaystransparent:b"},
+	{"OverlappingElementsBoxType", "position:v size:v orientation:o "
+	 "format:a spacing:f"},
+	{"checkboxType", "position:v quadTextureSprite:s tooltip:s "
+	 "tooltipText:s delayedTooltipText:s buttonText:s buttonFont:s "
+	 "orientation:o shortcut:s"},
+	{"editBoxType", "position:v textureFile:s font:s borderSize:v size:v "
+	 "text:s orientation:o"},
+	{"listboxType", "position:v background:s size:v orientation:o "
+	 "spacing:i scrollbartype:s borderSize:v priority:i step:i "
+	 "horizontal:b offset:v allwaystransparent:b"},
+	{"shieldtype", "spriteType:s position:v rotation:f"},
+	{"positionType", "position:v"}
+};
+
+static struct def_type const bitmap_font_type = {
+	"bitmapfont", "fontname:s color:h effect:b colorcodes:C"
+};
+
+static struct def_type const font_type = {
+	"font", "fontname:s height:i charset:s color:h"
+};
+
+static char const* const strings[] = {
+	"GFX_button_small", "gfx\\interface\\button.dds", "vic_18",
+	"Arial12", "FE_LOAD_GAME", "A longer piece of text with spaces"
+};
+static char const* const orientations[] = {
+	"UPPER_LEFT", "LOWER_LEFT", "CENTER", "CENTER_UP", "CENTER_DOWN",
+	"UPPER_RIGHT", "LOWER_RIGHT"
+};
+static char const* const formats[] = {
+	"left", "centre", "center", "right", "justified"
+};
+static char const* const click_sounds[] = {
+	"click", "close_window", "start_game"
+};
+static char const* const load_types[] = {"INGAME", "BACKEND", "FRONTEND"};
+static char const* const floats[] = {
+	"1.0", "0.5", "-2.25", "3", "0.125", "12.75", "0.1", "0.333"
+};
+
+#define COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+/* Bytes written by finished files. */
+static size_t written;
+static unsigned long names;
+
+static void indent(FILE* fp, int depth) {
+	int i;
+	for (i = 0; i < depth; i++) fputc('\t', fp);
+}
+
+static void write_rgb(FILE* fp) {
+	fprintf(fp, "{ %s %s %s }", floats[random_below(COUNT(floats))],
+	        floats[random_below(COUNT(floats))],
+	        floats[random_below(COUNT(floats))]);
+}
+
+static void write_value(FILE* fp, char kind, int depth) {
+	switch (kind) {
+	case 's':
+		fprintf(fp, "\"%s\"", strings[random_below(COUNT(strings))]);
+		break;
+	case 'i':
+		fprintf(fp, "%ld", (long) random_below(1000) - 500);
+		break;
+	case 'f':
+		fputs(floats[random_below(COUNT(floats))], fp);
+		break;
+	case 'b':
+		fputs(random_below(2) ? "yes" : "no", fp);
+		break;
+	case 'v':
+		fprintf(fp, "{ x = %ld y = %ld }", (long) random_below(1920) - 100,
+		        (long) random_below(1080) - 100);
+		break;
+	case 'c':
+		write_rgb(fp);
+		break;
+	case 'h':
+		fprintf(fp, "0x%08lx", (unsigned long) next_random());
+		break;
+	case 'o':
+		fprintf(fp, "\"%s\"",
+		        orientations[random_below(COUNT(orientations))]);
+		break;
+	case 'a':
+		fputs(formats[random_below(COUNT(formats))], fp);
+		break;
+	case 'k':
+		fputs(click_sounds[random_below(COUNT(click_sounds))], fp);
+		break;
+	case 'l':
+		fprintf(fp, "\"%s\"", load_types[random_below(COUNT(load_types))]);
+		break;
+	case 'C':
+		fputs("{\n", fp);
+		indent(fp, depth + 1);
+		fputs("W = ", fp);
+		write_rgb(fp);
+		fputs(" G = ", fp);
+		write_rgb(fp);
+		fputs(" R = ", fp);
+		write_rgb(fp);
+		fputc('\n', fp);
+		indent(fp, depth);
+		fputc('}', fp);
+		break;
+	default:
+		fprintf(stderr, "Unknown property kind '%c'.\n", kind);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* Writes the name and about two thirds of the other properties, each on its
+ * own line, with the occasional comment. */
+static void write_properties(FILE* fp, struct def_type const* type, int depth) {
+	char const* property = type->properties;
+	indent(fp, depth);
+	fprintf(fp, "name = \"%s_%lu\"\n", type->name, names++);
+	while (*property != '\0') {
+		size_t length = strcspn(property, ":");
+		char kind = property[length + 1];
+		if (random_below(3) != 0) {
+			indent(fp, depth);
+			fprintf(fp, "%.*s = ", (int) length, property);
+			write_value(fp, kind, depth);
+			fputc('\n', fp);
+		}
+		if (random_below(40) == 0) {
+			indent(fp, depth);
+			fputs("# a comment with { braces } and = signs\n", fp);
+		}
+		property += length + 2;
+		while (*property == ' ') property++;
+	}
+}
+
+static void write_def(FILE* fp, struct def_type const* type, int depth) {
+	indent(fp, depth);
+	fprintf(fp, "%s = {\n", type->name);
+	write_properties(fp, type, depth + 1);
+	indent(fp, depth);
+	fputs("}\n", fp);
+}
+
+/* Containers get up to four children while there is depth left. */
+static void write_widget(FILE* fp, size_t type, int depth, int nesting) {
+	struct def_type const* def = &widget_types[type];
+	indent(fp, depth);
+	fprintf(fp, "%s = {\n", def->name);
+	write_properties(fp, def, depth + 1);
+	if (type < CONTAINER_TYPES && nesting > 0) {
+		uint32_t children = random_below(5);
+		uint32_t i;
+		for (i = 0; i < children; i++) {
+			write_widget(fp, random_below(COUNT(widget_types)),
+			             depth + 1, nesting - 1);
+		}
+	}
+	indent(fp, depth);
+	fputs("}\n", fp);
+}
+
+static FILE* create(char const* path) {
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return fp;
+}
+
+static void finish(FILE* fp, char const* path) {
+	long size = ftell(fp);
+	if (size > 0) written += (size_t) size;
+	if (ferror(fp) || fclose(fp) != 0) {
+		fprintf(stderr, "Failed to write %s: %s\n", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void make_directory_or_die(char const* path) {
+	if (make_directory(path) != 0 && errno != EEXIST) {
+		fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void write_gfx(char const* path) {
+	FILE* fp = create(path);
+	size_t i;
+	fputs("spriteTypes = {\n", fp);
+	while ((size_t) ftell(fp) < FILE_SIZE) {
+		write_def(fp, &sprite_types[random_below(COUNT(sprite_types))], 1);
+	}
+	fputs("}\n\nbitmapfonts = {\n", fp);
+	for (i = 0; i < 4; i++) write_def(fp, &bitmap_font_type, 1);
+	fputs("}\n\nfonts = {\n", fp);
+	for (i = 0; i < 4; i++) write_def(fp, &font_type, 1);
+	fputs("}\n", fp);
+	finish(fp, path);
+}
+
+static void write_gui(char const* path, int nesting) {
+	FILE* fp = create(path);
+	fputs("guiTypes = {\n", fp);
+	while ((size_t) ftell(fp) < FILE_SIZE) {
+		/* Top-level definitions are mostly windows, as in the game. */
+		size_t type = random_below(4) != 0
+		              ? random_below(CONTAINER_TYPES)
+		              : random_below(COUNT(widget_types));
+		write_widget(fp, type, 1, nesting);
+	}
+	fputs("}\n", fp);
+	finish(fp, path);
+}
+
+static void write_font_desc(char const* path) {
+	FILE* fp = create(path);
+	int c;
+	fputs("info face=\"Arial\" size=18 bold=0 italic=0 charset=\"ANSI\" "
+	      "stretchH=100 smooth=1 aa=1 padding=0,0,0,0 spacing=1,1\n"
+	      "common lineHeight=22 base=18 scaleW=256 scaleH=256 pages=1\n", fp);
+	for (c = 32; c < 256; c++) {
+		fprintf(fp, "char id=%d x=%d y=%d width=%d height=14 xoffset=-1 "
+		        "yoffset=3 xadvance=%d page=0\n",
+		        c, c * 9 % 256, c / 28 * 16, 6 + c % 5, 7 + c % 5);
+	}
+	fputs("kernings count=4\n"
+	      "kerning first=32 second=65 amount=-1\n"
+	      "kerning first=65 second=86 amount=-2\n"
+	      "kerning first=84 second=111 amount=-1\n"
+	      "kerning first=86 second=97 amount=-1\n", fp);
+	finish(fp, path);
+}
+
+int main(int argc, char** argv) {
+	char path[4096];
+	char const* directory;
+	double megabytes = 4;
+	int nesting = 3;
+	size_t target;
+	unsigned n;
+	if (argc < 2 || argc > 5) {
+		fprintf(stderr, "Usage: %s <directory> [megabytes] [depth] [seed]\n",
+		        argv[0]);
+		return EXIT_FAILURE;
+	}
+	directory = argv[1];
+	if (argc > 2) megabytes = atof(argv[2]);
+	if (argc > 3) nesting = atoi(argv[3]);
+	rng_state = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+	if (rng_state == 0) rng_state = 1;
+	if (strlen(directory) > sizeof(path) - 32) {
+		fprintf(stderr, "Path too long: %s\n", directory);
+		return EXIT_FAILURE;
+	}
+	target = (size_t) (megabytes * 1024 * 1024);
+
+	make_directory_or_die(directory);
+	sprintf(path, "%s/interface", directory);
+	make_directory_or_die(path);
+	sprintf(path, "%s/gfx", directory);
+	make_directory_or_die(path);
+	sprintf(path, "%s/gfx/fonts", directory);
+	make_directory_or_die(path);
+
+	for (n = 0; written < target; n++) {
+		sprintf(path, "%s/interface/bench%04u.%s", directory, n / 2,
+		        n % 2 == 0 ? "gfx" : "gui");
+		if (n % 2 == 0) {
+			write_gfx(path);
+		} else {
+			write_gui(path, nesting);
+		}
+	}
+	sprintf(path, "%s/gfx/fonts/bench.fnt", directory);
+	write_font_desc(path);
+
+	printf("Wrote %u files, %.1f MB, to %s.\n", n,
+	       (double) written / (1024 * 1024), directory);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,22 @@
+#ifndef OV2_BENCH_RANDOM_H
+#define OV2_BENCH_RANDOM_H
+
+#include <stdint.h>
+
+/* xorshift64*, the same sequence on every platform, so that what a benchmark
+ * generates only depends on its arguments. Each benchmark is a program of its
+ * own and includes this once. `rng_state` is the seed, never 0. */
+static uint64_t rng_state = 1;
+
+static uint32_t next_random(void) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (uint32_t) ((rng_state * UINT64_C(2685821657736338717)) >> 32);
+}
+
+static uint32_t random_below(uint32_t n) {
+	return next_random() % n;
+}
+
+#endif /*OV2_BENCH_RANDOM_H*/
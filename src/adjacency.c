@@ -0,0 +1,383 @@
+#include "adjacency.h"
+#include "csv.h"
+#include "fs.h"
+#include "workers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Rows scanned by one task. */
+#define BAND_HEIGHT 64
+
+/* An edge is packed as the smaller index in the high half and the larger in
+ * the low half, so that sorted edges are grouped by their first end. */
+static uint32_t pack_edge(uint16_t a, uint16_t b) {
+	return a < b ? (uint32_t) a << 16 | b : (uint32_t) b << 16 | a;
+}
+
+struct edge_list {
+	uint32_t* items;
+	size_t count;
+	size_t capacity;
+	bool failed;
+};
+
+static void push_edge(struct edge_list* list, uint32_t edge) {
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity == 0 ? 256 : list->capacity * 2;
+		uint32_t* items = realloc(list->items, capacity * sizeof(uint32_t));
+		if (items == NULL) {
+			list->failed = true;
+			return;
+		}
+		list->items = items;
+		list->capacity = capacity;
+	}
+	list->items[list->count++] = edge;
+}
+
+static int compare_edges(void const* a, void const* b) {
+	uint32_t x = *(uint32_t const*) a;
+	uint32_t y = *(uint32_t const*) b;
+	return (x > y) - (x < y);
+}
+
+static void sort_unique(struct edge_list* list) {
+	size_t i, count = 0;
+	if (list->count == 0) return;
+	qsort(list->items, list->count, sizeof(uint32_t), compare_edges);
+	for (i = 1; i < list->count; i++) {
+		if (list->items[i] != list->items[count]) list->items[++count] = list->items[i];
+	}
+	list->count = count + 1;
+}
+
+struct edge_scan {
+	struct province_map const* map;
+	struct edge_list* bands;
+};
+
+/* Compares every pixel of the band with the one to its right and the one
+ * below it, which may be in the next band. A border is mostly between the
+ * same two provinces for a while, so repeats of the last edge are dropped
+ * before they are stored. */
+static void scan_band(void* data, size_t index) {
+	struct edge_scan const* scan = data;
+	struct province_map const* map = scan->map;
+	struct edge_list* list = &scan->bands[index];
+	uint32_t first = (uint32_t) index * BAND_HEIGHT;
+	uint32_t end = first + BAND_HEIGHT < map->height ? first + BAND_HEIGHT : map->height;
+	uint32_t last = 0xffffffffu;
+	uint32_t x, y;
+	for (y = first; y < end; y++) {
+		uint16_t const* row = map->pixels + (size_t) y * map->width;
+		uint16_t const* below = y + 1 < map->height ? row + map->width : NULL;
+		for (x = 0; x < map->width; x++) {
+			uint16_t province = row[x];
+			if (province == PROVINCE_NONE) continue;
+			if (x + 1 < map->width && row[x + 1] != province && row[x + 1] != PROVINCE_NONE) {
+				uint32_t edge = pack_edge(province, row[x + 1]);
+				if (edge != last) push_edge(list, last = edge);
+			}
+			if (below != NULL && below[x] != province && below[x] != PROVINCE_NONE) {
+				uint32_t edge = pack_edge(province, below[x]);
+				if (edge != last) push_edge(list, last = edge);
+			}
+		}
+	}
+	sort_unique(list);
+}
+
+/* Collects the edges of the bands into the first, each band is freed. */
+static bool merge_bands(struct edge_list* bands, size_t bands_count) {
+	size_t total = 0;
+	size_t i;
+	bool success = true;
+	for (i = 0; i < bands_count; i++) {
+		success &= !bands[i].failed;
+		total += bands[i].count;
+	}
+	if (success && bands[0].capacity < total) {
+		uint32_t* items = realloc(bands[0].items, total * sizeof(uint32_t));
+		if (items == NULL) {
+			success = false;
+		} else {
+			bands[0].items = items;
+			bands[0].capacity = total;
+		}
+	}
+	for (i = 1; i < bands_count; i++) {
+		if (success) {
+			memcpy(bands[0].items + bands[0].count, bands[i].items,
+			       bands[i].count * sizeof(uint32_t));
+			bands[0].count += bands[i].count;
+		}
+		free(bands[i].items);
+	}
+	if (success) sort_unique(&bands[0]);
+	return success;
+}
+
+/* Reads `From;To;Type;...` rows, ids as in map/definition.csv. Rows naming
+ * province 0 are placeholders and skipped. */
+static bool read_adjacencies(struct province_table const* provinces, char const* path,
+                             struct edge_list* added, struct edge_list* removed) {
+	struct csv_file* csv = csv_open(path);
+	size_t row;
+	bool success = true;
+	if (csv == NULL) return false;
+	/* The first line names the columns. */
+	row = csv->row_count != 0 && csv->line_numbers[0] == 1 ? 1 : 0;
+	for (; row < csv->row_count; row++) {
+		unsigned int from, to;
+		struct province_definition const* a;
+		struct province_definition const* b;
+		struct csv_field type;
+		if (!csv_get_uint(csv, row, 0, &from) || !csv_get_uint(csv, row, 1, &to)) {
+			fprintf(stderr, "Failed to read '%s'.\n", path);
+			success = false;
+			break;
+		}
+		if (from == 0 || to == 0 || from == to) continue;
+		a = province_by_id(provinces, from);
+		b = province_by_id(provinces, to);
+		if (a == NULL || b == NULL) {
+			fprintf(stderr, "WARNING: Ignoring the adjacency of unknown province %u at %s:%lu\n",
+			        a == NULL ? from : to, path, (unsigned long) csv->line_numbers[row]);
+			continue;
+		}
+		csv_get_field(csv, row, 2, &type);
+		push_edge(type.length == strlen("impassable")
+		          && memcmp(type.data, "impassable", type.length) == 0 ? removed : added,
+		          pack_edge((uint16_t) (a - provinces->items), (uint16_t) (b - provinces->items)));
+	}
+	csv_close(csv);
+	return success && !added->failed && !removed->failed;
+}
+
+/* Drops the edges of `edges` that are in `removed`, both sorted. */
+static void remove_edges(struct edge_list* edges, struct edge_list const* removed) {
+	size_t i, j = 0, count = 0;
+	for (i = 0; i < edges->count; i++) {
+		while (j < removed->count && removed->items[j] < edges->items[i]) j++;
+		if (j == removed->count || removed->items[j] != edges->items[i]) {
+			edges->items[count++] = edges->items[i];
+		}
+	}
+	edges->count = count;
+}
+
+/* Lays the sorted edges out at both ends. Going through them in order, the
+ * neighbours of a province smaller than it come first, then the larger ones,
+ * each in increasing order. */
+static bool build_rows(struct edge_list const* edges, struct province_adjacency* adjacency) {
+	size_t count = adjacency->provinces_count;
+	uint32_t* next;
+	size_t i;
+	adjacency->offsets = calloc(count + 1, sizeof(uint32_t));
+	adjacency->neighbors = malloc(edges->count * 2 * sizeof(uint16_t) + 1);
+	next = malloc(count * sizeof(uint32_t) + 1);
+	if (adjacency->offsets == NULL || adjacency->neighbors == NULL || next == NULL) {
+		free(next);
+		return false;
+	}
+	for (i = 0; i < edges->count; i++) {
+		adjacency->offsets[(edges->items[i] >> 16) + 1]++;
+		adjacency->offsets[(edges->items[i] & 0xffff) + 1]++;
+	}
+	for (i = 0; i < count; i++) {
+		adjacency->offsets[i + 1] += adjacency->offsets[i];
+		next[i] = adjacency->offsets[i];
+	}
+	for (i = 0; i < edges->count; i++) {
+		uint16_t a = (uint16_t) (edges->items[i] >> 16);
+		uint16_t b = (uint16_t) (edges->items[i] & 0xffff);
+		adjacency->neighbors[next[a]++] = b;
+		adjacency->neighbors[next[b]++] = a;
+	}
+	free(next);
+	return true;
+}
+
+bool build_province_adjacency(
+	struct province_table const* provinces,
+	struct province_map const* map,
+	char const* adjacencies_path,
+	struct province_adjacency* adjacency
+) {
+	size_t bands_count = ((size_t) map->height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+	struct edge_list* bands = calloc(bands_count + 1, sizeof(struct edge_list));
+	struct edge_list added, removed;
+	struct edge_scan scan;
+	bool success = true;
+	memset(adjacency, 0, sizeof(struct province_adjacency));
+	memset(&added, 0, sizeof(struct edge_list));
+	memset(&removed, 0, sizeof(struct edge_list));
+	if (bands == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the adjacency graph: %s\n",
+		        strerror(errno));
+		return false;
+	}
+	adjacency->provinces_count = provinces->count;
+
+	scan.map = map;
+	scan.bands = bands;
+	parallel_for(bands_count, scan_band, &scan);
+	if (!merge_bands(bands, bands_count == 0 ? 1 : bands_count)) {
+		fprintf(stderr, "Failed to allocate memory for the adjacency graph.\n");
+		success = false;
+	} else if (adjacencies_path != NULL
+	           && !read_adjacencies(provinces, adjacencies_path, &added, &removed)) {
+		success = false;
+	} else {
+		size_t i;
+		for (i = 0; i < added.count; i++) push_edge(&bands[0], added.items[i]);
+		sort_unique(&bands[0]);
+		sort_unique(&removed);
+		remove_edges(&bands[0], &removed);
+		if (bands[0].failed || !build_rows(&bands[0], adjacency)) {
+			fprintf(stderr, "Failed to allocate memory for the adjacency graph.\n");
+			success = false;
+		}
+	}
+
+	if (!success) free_province_adjacency(adjacency);
+	free(bands[0].items);
+	free(bands);
+	free(added.items);
+	free(removed.items);
+	return success;
+}
+
+void free_province_adjacency(struct province_adjacency* adjacency) {
+	free(adjacency->offsets);
+	free(adjacency->neighbors);
+	memset(adjacency, 0, sizeof(struct province_adjacency));
+}
+
+/* region cache */
+
+/* The cache is a header, the files it was built from, then the offsets and
+ * the neighbours as they are in memory. */
+
+#define CACHE_MAGIC 0x4132564fu /* "OV2A" */
+#define CACHE_VERSION 1
+
+struct cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t provinces_count;
+	uint64_t files_count;
+	uint64_t neighbors_count;
+};
+
+bool save_adjacency_cache(
+	char const* path,
+	char const* const* files,
+	size_t files_count,
+	struct province_adjacency const* adjacency
+) {
+	struct cache_header header;
+	struct file_stamp* stamps = calloc(files_count + 1, sizeof(struct file_stamp));
+	struct file_part parts[4];
+	bool success = true;
+
+	memset(&header, 0, sizeof(struct cache_header));
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.provinces_count = adjacency->provinces_count;
+	header.files_count = files_count;
+	header.neighbors_count = adjacency->offsets[adjacency->provinces_count];
+
+	if (stamps == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the adjacency cache.\n");
+		success = false;
+		goto out;
+	}
+	if (!stamp_files(files, files_count, stamps)) {
+		success = false;
+		goto out;
+	}
+
+	parts[0].data = &header;
+	parts[0].size = sizeof(struct cache_header);
+	parts[1].data = stamps;
+	parts[1].size = files_count * sizeof(struct file_stamp);
+	parts[2].data = adjacency->offsets;
+	parts[2].size = (adjacency->provinces_count + 1) * sizeof(uint32_t);
+	parts[3].data = adjacency->neighbors;
+	parts[3].size = (size_t) header.neighbors_count * sizeof(uint16_t);
+	success = write_file_atomically(path, parts, 4);
+
+out:
+	free(stamps);
+	return success;
+}
+
+/* The offsets have to grow from 0 to the number of neighbours, which all have
+ * to be provinces. */
+static bool check_rows(struct province_adjacency const* adjacency, size_t neighbors_count) {
+	size_t i;
+	if (adjacency->offsets[0] != 0
+	    || adjacency->offsets[adjacency->provinces_count] != neighbors_count) {
+		return false;
+	}
+	for (i = 0; i < adjacency->provinces_count; i++) {
+		if (adjacency->offsets[i] > adjacency->offsets[i + 1]) return false;
+	}
+	for (i = 0; i < neighbors_count; i++) {
+		if (adjacency->neighbors[i] >= adjacency->provinces_count) return false;
+	}
+	return true;
+}
+
+bool load_adjacency_cache(
+	char const* path,
+	char const* const* files,
+	size_t files_count,
+	size_t provinces_count,
+	struct province_adjacency* adjacency
+) {
+	struct mapped_file file;
+	struct cache_header header;
+	struct file_stamp const* stamps;
+	size_t offsets_size = (provinces_count + 1) * sizeof(uint32_t);
+	size_t neighbors_size;
+	bool success;
+	memset(adjacency, 0, sizeof(struct province_adjacency));
+	if (!map_file(path, &file)) return false;
+	if (file.size < sizeof(struct cache_header)) {
+		unmap_file(&file);
+		return false;
+	}
+	memcpy(&header, file.data, sizeof(struct cache_header));
+	neighbors_size = (size_t) header.neighbors_count * sizeof(uint16_t);
+	stamps = (struct file_stamp const*) (file.data + sizeof(struct cache_header));
+	success = header.magic == CACHE_MAGIC
+	          && header.version == CACHE_VERSION
+	          && header.provinces_count == provinces_count
+	          && header.files_count == files_count
+	          && header.neighbors_count <= UINT32_MAX
+	          && file.size == sizeof(struct cache_header)
+	                          + files_count * sizeof(struct file_stamp)
+	                          + offsets_size + neighbors_size
+	          && are_files_unchanged(files, files_count, stamps);
+	if (success) {
+		char const* data = (char const*) (stamps + files_count);
+		adjacency->provinces_count = provinces_count;
+		adjacency->offsets = malloc(offsets_size);
+		adjacency->neighbors = malloc(neighbors_size + 1);
+		success = adjacency->offsets != NULL && adjacency->neighbors != NULL;
+		if (success) {
+			memcpy(adjacency->offsets, data, offsets_size);
+			memcpy(adjacency->neighbors, data + offsets_size, neighbors_size);
+			success = check_rows(adjacency, (size_t) header.neighbors_count);
+		}
+		if (!success) free_province_adjacency(adjacency);
+	}
+	unmap_file(&file);
+	return success;
+}
+
+/* endregion */
@@ -0,0 +1,54 @@
+#ifndef OV2_ADJACENCY_H
+#define OV2_ADJACENCY_H
+
+#include "province_definitions.h"
+#include "province_map.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Where the adjacency graph is stored between runs. */
+#define ADJACENCY_CACHE_PATH "ov2_adjacency.cache"
+
+/* Which provinces border which, by index in the province table, as a
+ * compressed sparse row: the neighbours of province i are neighbors[offsets[i]]
+ * up to neighbors[offsets[i + 1]], in increasing order. Every edge is stored
+ * at both of its ends. */
+struct province_adjacency {
+	size_t provinces_count;
+	uint32_t* offsets;
+	uint16_t* neighbors;
+};
+
+/* Finds the provinces whose pixels touch horizontally or vertically on the
+ * worker pool, then adds the adjacencies listed in `adjacencies_path`, or
+ * removes those of type "impassable". `adjacencies_path` may be NULL. Returns
+ * false, with an empty graph, on failure. */
+bool build_province_adjacency(
+	struct province_table const* provinces,
+	struct province_map const* map,
+	char const* adjacencies_path,
+	struct province_adjacency* adjacency
+);
+
+void free_province_adjacency(struct province_adjacency* adjacency);
+
+/* Loads the graph stored in `path`. Returns false, with an empty graph, if
+ * there is no cache or it was not built from exactly `files`, in that order
+ * and with their current contents, for `provinces_count` provinces. */
+bool load_adjacency_cache(
+	char const* path,
+	char const* const* files,
+	size_t files_count,
+	size_t provinces_count,
+	struct province_adjacency* adjacency
+);
+
+bool save_adjacency_cache(
+	char const* path,
+	char const* const* files,
+	size_t files_count,
+	struct province_adjacency const* adjacency
+);
+
+#endif /*OV2_ADJACENCY_H*/
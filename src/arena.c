@@ -0,0 +1,75 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define ARENA_BLOCK_SIZE ((size_t) 64 * 1024)
+#define ARENA_ALIGNMENT ((size_t) 16)
+#define ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+struct arena_block {
+	struct arena_block* next;
+	size_t used;
+	size_t capacity;
+};
+
+void* arena_alloc(struct arena* arena, size_t size) {
+	struct arena_block* block = arena->blocks;
+	char* result;
+	size = ALIGN(size);
+	if (block == NULL || block->capacity - block->used < size) {
+		size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+		block = malloc(ALIGN(sizeof(struct arena_block)) + capacity);
+		if (block == NULL) {
+			fprintf(stderr, "Failed to allocate: %s\n", strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		block->used = 0;
+		block->capacity = capacity;
+		if (arena->blocks != NULL && capacity > ARENA_BLOCK_SIZE) {
+			/* Oversized blocks go behind the current one, so its
+			 * remaining space is still used. */
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+		} else {
+			block->next = arena->blocks;
+			arena->blocks = block;
+		}
+	}
+	result = (char*) block + ALIGN(sizeof(struct arena_block)) + block->used;
+	block->used += size;
+	memset(result, 0, size);
+	return result;
+}
+
+char* arena_strndup(struct arena* arena, char const* str, size_t len) {
+	char* result = arena_alloc(arena, len + 1);
+	memcpy(result, str, len);
+	result[len] = '\0';
+	return result;
+}
+
+void arena_merge(struct arena* arena, struct arena* other) {
+	struct arena_block* last = other->blocks;
+	if (last == NULL) return;
+	while (last->next != NULL) last = last->next;
+	if (arena->blocks == NULL) {
+		arena->blocks = other->blocks;
+	} else {
+		/* Keep the current block in front, it may still have room. */
+		last->next = arena->blocks->next;
+		arena->blocks->next = other->blocks;
+	}
+	other->blocks = NULL;
+}
+
+void arena_free(struct arena* arena) {
+	struct arena_block* block = arena->blocks;
+	while (block != NULL) {
+		struct arena_block* next = block->next;
+		free(block);
+		block = next;
+	}
+	arena->blocks = NULL;
+}
@@ -0,0 +1,25 @@
+#ifndef OV2_ARENA_H
+#define OV2_ARENA_H
+
+#include <stddef.h>
+
+struct arena_block;
+
+/* A bump allocator, everything allocated from an arena is released at once by
+ * `arena_free`. A zero-initialized arena is empty and ready for use. */
+struct arena {
+	struct arena_block* blocks;
+};
+
+/* Returns zeroed memory, exits on allocation failure. */
+void* arena_alloc(struct arena* arena, size_t size);
+
+/* Returns a NUL-terminated copy of the first `len` bytes of `str`. */
+char* arena_strndup(struct arena* arena, char const* str, size_t len);
+
+/* Moves every allocation of `other` into `arena`, leaving `other` empty. */
+void arena_merge(struct arena* arena, struct arena* other);
+
+void arena_free(struct arena* arena);
+
+#endif /*OV2_ARENA_H*/
@@ -1,108 +1,19 @@
 #include <GL/gl.h>
-#include <SOIL/SOIL.h>
 #include <stdio.h>
 #include <string.h>
 #include <malloc.h>
 #include <assert.h>
 #include "bitmap_font.h"
-
-struct frect {
-	float x, y, w, h;
-};
-
-/* region textures */
-
-static GLuint load_texture(char const* path) {
-	GLuint id;
-	char* full_path = malloc(strlen("gfx/fonts/") + strlen(path) + strlen(".tga") + 1);
-	if (full_path == NULL) {
-		fprintf(stderr, "Failed to allocate memory for full path.\n");
-		return 0;
-	}
-	strcpy(full_path, "gfx/fonts/");
-	strcat(full_path, path);
-	strcat(full_path, ".tga");
-	if ((id = SOIL_load_OGL_texture(
-		full_path,
-		SOIL_LOAD_RGBA,
-		SOIL_CREATE_NEW_ID,
-		0
-	)) == 0) {
-		fprintf(stderr, "SOIL loading error while loading "
-				"texture %s: %s\n", full_path,
-			SOIL_last_result());
-	}
-	free(full_path);
-	return id;
-}
-
-struct loaded_texture {
-	char const* name;
-	GLuint texture;
-	struct loaded_texture* next;
-};
-
-/* TODO: Let's not keep a global texture buffer like this. */
-static struct loaded_texture* loaded_textures = NULL;
-
-static GLuint find_texture(const char* name) {
-	struct loaded_texture* loaded_texture = loaded_textures;
-	for (; loaded_texture != NULL; loaded_texture = loaded_texture->next) {
-		if (strcmp(loaded_texture->name, name) == 0) {
-			return loaded_texture->texture;
-		}
-	}
-	return 0;
-}
-
-static GLuint find_or_load_texture(char const* name) {
-	GLuint texture = find_texture(name);
-	if (texture == 0 && (texture = load_texture(name), texture != 0)) {
-		struct loaded_texture* new_texture =
-			malloc(sizeof(struct loaded_texture));
-		new_texture->name = name;
-		new_texture->texture = texture;
-		new_texture->next = loaded_textures;
-		loaded_textures = new_texture;
-	}
-	return texture;
-}
-
-static void render_texture(
-	GLuint texture,
-	struct frect* srcrect,
-	struct frect* dstrect
-) {
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBegin(GL_QUADS);
-
-	glTexCoord2f(srcrect->x, srcrect->y);
-	glVertex2f(dstrect->x, dstrect->y);
-
-	glTexCoord2f(srcrect->x + srcrect->w, srcrect->y);
-	glVertex2f(dstrect->x + dstrect->w, dstrect->y);
-
-	glTexCoord2f(srcrect->x + srcrect->w, srcrect->y + srcrect->h);
-	glVertex2f(dstrect->x + dstrect->w, dstrect->y + dstrect->h);
-
-	glTexCoord2f(srcrect->x, srcrect->y + srcrect->h);
-	glVertex2f(dstrect->x, dstrect->y + dstrect->h);
-
-	glEnd();
-	glDisable(GL_BLEND);
-	glDisable(GL_TEXTURE_2D);
-}
-
-/* endregion */
+#include "texture.h"
+#include "intern.h"
+#include "vfs.h"
 
 /* region font description */
 
 static struct font_desc* load_font_desc(char const* path) {
 	struct font_desc* font_desc = NULL;
 	char* full_path = NULL;
+	char const* file;
 	font_desc = malloc(sizeof(struct font_desc));
 	if (font_desc == NULL) {
 		fprintf(stderr, "Failed to allocate memory for font description.\n");
@@ -111,69 +22,117 @@ static struct font_desc* load_font_desc(char const* path) {
 	full_path = malloc(strlen("gfx/fonts/") + strlen(path) + strlen(".fnt") + 1);
 	if (full_path == NULL) {
 		fprintf(stderr, "Failed to allocate memory for full path.\n");
+		free(font_desc);
 		return NULL;
 	}
 	strcpy(full_path, "gfx/fonts/");
 	strcat(full_path, path);
 	strcat(full_path, ".fnt");
-	parse_font_desc(full_path, font_desc);
+	if ((file = find_asset(full_path)) == NULL) {
+		fprintf(stderr, "Font description %s not found.\n", full_path);
+		free(full_path);
+		free(font_desc);
+		return NULL;
+	}
+	parse_font_desc(file, font_desc);
 	free(full_path);
 	return font_desc;
 }
 
-/* TODO: Again let's avoid these global buffers. */
-struct loaded_font_desc {
+/* The font name's texture is gfx/fonts/<name>.tga. */
+static struct texture const* load_font_texture(char const* name) {
+	struct texture const* texture;
+	char* full_path = malloc(strlen("gfx/fonts/") + strlen(name) + strlen(".tga") + 1);
+	if (full_path == NULL) {
+		fprintf(stderr, "Failed to allocate memory for full path.\n");
+		return NULL;
+	}
+	strcpy(full_path, "gfx/fonts/");
+	strcat(full_path, name);
+	strcat(full_path, ".tga");
+	texture = find_or_load_texture(intern(full_path));
+	free(full_path);
+	return texture;
+}
+
+/* TODO: Again let's avoid these global buffers. Font names are interned, so
+ * they are told apart by address. A font that could not be loaded is kept
+ * with neither description nor texture, so that it is not tried again. */
+struct loaded_font {
 	char const* name;
 	struct font_desc* font_desc;
-	struct loaded_font_desc* next;
+	struct texture const* texture;
+	struct loaded_font* next;
 };
 
-static struct loaded_font_desc* loaded_font_descs = NULL;
+static struct loaded_font* loaded_fonts = NULL;
 
-static struct font_desc* find_font_desc(char const* name) {
-	struct loaded_font_desc* loaded_font_desc = loaded_font_descs;
-	for (; loaded_font_desc != NULL; loaded_font_desc = loaded_font_desc->next) {
-		if (strcmp(loaded_font_desc->name, name) == 0) {
-			return loaded_font_desc->font_desc;
+static struct loaded_font const* find_or_load_font(char const* name) {
+	struct loaded_font* loaded_font = loaded_fonts;
+	for (; loaded_font != NULL; loaded_font = loaded_font->next) {
+		if (loaded_font->name == name) {
+			return loaded_font->font_desc != NULL ? loaded_font : NULL;
 		}
 	}
-	return NULL;
-}
-
-static struct font_desc* find_or_load_font_desc(char const* name) {
-	struct font_desc* font_desc = find_font_desc(name);
-	if (font_desc == NULL && (font_desc = load_font_desc(name), font_desc != NULL)) {
-		struct loaded_font_desc* new_font_desc =
-			malloc(sizeof(struct loaded_font_desc));
-		new_font_desc->name = name;
-		new_font_desc->font_desc = font_desc;
-		new_font_desc->next = loaded_font_descs;
-		loaded_font_descs = new_font_desc;
+	if ((loaded_font = malloc(sizeof(struct loaded_font))) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for font.\n");
+		return NULL;
 	}
-	return font_desc;
+	loaded_font->name = name;
+	loaded_font->font_desc = load_font_desc(name);
+	loaded_font->texture = load_font_texture(name);
+	if (loaded_font->font_desc == NULL || loaded_font->texture == NULL) {
+		if (loaded_font->font_desc != NULL) {
+			free_font_desc(loaded_font->font_desc);
+			free(loaded_font->font_desc);
+			loaded_font->font_desc = NULL;
+		}
+		loaded_font->texture = NULL;
+	}
+	loaded_font->next = loaded_fonts;
+	loaded_fonts = loaded_font;
+	return loaded_font->font_desc != NULL ? loaded_font : NULL;
 }
 
 /* endregion */
 
+/* Sets the color of the font's color code `code`, or of the font itself if it
+ * has no such code. Color codes are written from 0 to 255 in the game's
+ * files, unlike the font's own color. */
+static void set_color(struct bitmap_font const* bitmap_font, char code) {
+	size_t i;
+	for (i = 0; i < bitmap_font->color_codes.count; i++) {
+		struct color_code const* color = &bitmap_font->color_codes.items[i];
+		if (color->name[0] == code && color->name[1] == '\0') {
+			glColor4f((GLfloat) (color->rgb.r / 255.0),
+				  (GLfloat) (color->rgb.g / 255.0),
+				  (GLfloat) (color->rgb.b / 255.0),
+				  (GLfloat) bitmap_font->color.a);
+			return;
+		}
+	}
+	glColor4f((GLfloat) bitmap_font->color.r,
+		  (GLfloat) bitmap_font->color.g,
+		  (GLfloat) bitmap_font->color.b,
+		  (GLfloat) bitmap_font->color.a);
+}
+
 void render_bitmap_font(
 	struct bitmap_font* bitmap_font,
 	char const* text,
 	float x,
 	float y
 ) {
-	struct font_desc* font_desc = find_or_load_font_desc(bitmap_font->font_name);
-	GLuint texture = find_or_load_texture(bitmap_font->font_name);
+	struct loaded_font const* font = find_or_load_font(bitmap_font->font_name);
+	struct font_desc const* font_desc;
+	float texture_width, texture_height;
 	size_t i = 0;
-	GLint texture_width, texture_height = 0;
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &texture_width);
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &texture_height);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	if (font == NULL || font->texture->id == 0) return;
+	font_desc = font->font_desc;
+	texture_width = (float) font->texture->width;
+	texture_height = (float) font->texture->height;
 
-	glColor4f((GLfloat) bitmap_font->color.r,
-		  (GLfloat) bitmap_font->color.g,
-		  (GLfloat) bitmap_font->color.b,
-		  (GLfloat) bitmap_font->color.a);
+	set_color(bitmap_font, '!');
 
 	for (i = 0; i < strlen(text); i++) {
 		struct frect srcrect;
@@ -184,17 +143,21 @@ void render_bitmap_font(
 			y += (float) font_desc->line_height;
 			continue;
 		}
+		if (c == (unsigned char) COLOR_CODE_MARKER && text[i + 1] != '\0') {
+			set_color(bitmap_font, text[++i]);
+			continue;
+		}
 		if (font_desc->chars[c].id == 0) return;
 		assert(font_desc->chars[c].id == c);
-		srcrect.x = (float) font_desc->chars[c].x / (float) texture_width;
-		srcrect.y = (float) font_desc->chars[c].y / (float) texture_height;
-		srcrect.w = (float) font_desc->chars[c].width / (float) texture_width;
-		srcrect.h = (float) font_desc->chars[c].height / (float) texture_height;
+		srcrect.x = (float) font_desc->chars[c].x / texture_width;
+		srcrect.y = (float) font_desc->chars[c].y / texture_height;
+		srcrect.w = (float) font_desc->chars[c].width / texture_width;
+		srcrect.h = (float) font_desc->chars[c].height / texture_height;
 		dstrect.x = x + (float) font_desc->chars[c].xoffset;
 		dstrect.y = y + (float) font_desc->chars[c].yoffset;
 		dstrect.w = (float) font_desc->chars[c].width;
 		dstrect.h = (float) font_desc->chars[c].height;
-		render_texture(texture, &srcrect, &dstrect);
+		render_texture(font->texture, &srcrect, &dstrect);
 		x += (float) font_desc->chars[c].xadvance;
 	}
 
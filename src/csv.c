@@ -1,175 +1,301 @@
- #include "csv.h"
-#include <malloc.h>
+#include "csv.h"
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <limits.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+struct offset_list {
+	uint32_t* items;
+	size_t count;
+	size_t capacity;
+};
+
+static bool push_offset(struct offset_list* list, uint32_t offset) {
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+		uint32_t* items = realloc(list->items, capacity * sizeof(uint32_t));
+		if (items == NULL) return false;
+		list->items = items;
+		list->capacity = capacity;
+	}
+	list->items[list->count++] = offset;
+	return true;
+}
+
+/* State of the split while the file is swept for ';', '\n' and '#'. */
+struct splitter {
+	char const* data;
+	struct offset_list offsets;
+	struct offset_list rows;
+	struct offset_list line_numbers;
+	size_t line_start;
+	uint32_t line_number;
+	bool in_comment;
+	/* End of the current line before a comment, once one is seen. */
+	size_t content_end;
+	bool failed;
+};
+
+static void start_row(struct splitter* s) {
+	s->failed |= !push_offset(&s->rows, (uint32_t) s->offsets.count)
+	             || !push_offset(&s->offsets, (uint32_t) s->line_start)
+	             || !push_offset(&s->line_numbers, s->line_number);
+}
+
+/* Closes the current row at `end`, dropping it if there is nothing before
+ * the end or the comment. */
+static void end_row(struct splitter* s, size_t end) {
+	if (s->failed) return;
+	if (!s->in_comment) {
+		if (end != s->line_start && s->data[end - 1] == '\r') end--;
+		s->content_end = end;
+	}
+	if (s->content_end == s->line_start) {
+		s->offsets.count = s->rows.items[--s->rows.count];
+		s->line_numbers.count--;
+	} else {
+		s->failed |= !push_offset(&s->offsets, (uint32_t) s->content_end + 1);
+	}
+}
+
+static void handle_delimiter(struct splitter* s, size_t offset) {
+	switch (s->data[offset]) {
+	case ';':
+		if (!s->in_comment) {
+			s->failed |= !push_offset(&s->offsets, (uint32_t) offset + 1);
+		}
+		break;
+	case '#':
+		if (!s->in_comment) {
+			s->content_end = offset;
+			s->in_comment = true;
+		}
+		break;
+	default:
+		end_row(s, offset);
+		s->line_start = offset + 1;
+		s->line_number += 1;
+		s->in_comment = false;
+		start_row(s);
+		break;
+	}
+}
+
+/* The delimiters are found a vector at a time where the target has SSE2
+ * (always the case on x86-64) or AVX2, and handled in order from the mask of
+ * their positions. Vectors are only loaded while they fit before the end, the
+ * mapped file is not padded. */
+static void split(struct splitter* s, size_t size) {
+	char const* data = s->data;
+	size_t offset = 0;
+	start_row(s);
+#if defined(__AVX2__)
+	for (; size - offset >= 32; offset += 32) {
+		__m256i chunk = _mm256_loadu_si256((__m256i const*) (data + offset));
+		uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(';')),
+				_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))),
+			_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('#'))));
+		for (; mask != 0; mask &= mask - 1) {
+			handle_delimiter(s, offset + (size_t) __builtin_ctz(mask));
+		}
+	}
+#endif
+#if defined(__SSE2__)
+	for (; size - offset >= 16; offset += 16) {
+		__m128i chunk = _mm_loadu_si128((__m128i const*) (data + offset));
+		unsigned mask = (unsigned) _mm_movemask_epi8(_mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8(';')),
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+			_mm_cmpeq_epi8(chunk, _mm_set1_epi8('#'))));
+		for (; mask != 0; mask &= mask - 1) {
+			handle_delimiter(s, offset + (size_t) __builtin_ctz(mask));
+		}
+	}
+#endif
+	for (; offset != size; offset++) {
+		char c = data[offset];
+		if (c == ';' || c == '\n' || c == '#') handle_delimiter(s, offset);
+	}
+	end_row(s, size);
+	s->failed |= !push_offset(&s->rows, (uint32_t) s->offsets.count);
+}
 
 struct csv_file* csv_open(char const* filename) {
 	struct csv_file* csv = malloc(sizeof(struct csv_file));
+	struct splitter s;
 	if (csv == NULL) {
 		fprintf(stderr, "Failed to allocate memory for csv_file: %s\n", strerror(errno));
 		return NULL;
 	}
 
 	csv->filename = filename;
-	csv->file = fopen(filename, "r");
-	if (csv->file == NULL) {
+	if (!map_file(filename, &csv->file)) {
 		fprintf(stderr, "Failed to open %s: %s\n", filename, strerror(errno));
+		free(csv);
+		return NULL;
 	}
-	csv->line_capacity = 1024;
-	csv->line = malloc(csv->line_capacity);
-	if (csv->line == NULL) {
-		fprintf(stderr, "Failed to allocate memory for %s: %s\n", filename, strerror(errno));
+	/* The offsets, one past the end of a field plus one included, are kept
+	 * in 32 bits. */
+	if (csv->file.size >= UINT32_MAX - 1) {
+		fprintf(stderr, "Failed to open %s: File too large\n", filename);
+		unmap_file(&csv->file);
+		free(csv);
+		return NULL;
 	}
-	csv->line_length = 0;
-	csv->line_number = 0;
-	csv->column_number = 0;
-	if (csv->line == NULL || csv->file == NULL) {
-		csv_close(csv);
-		csv = NULL;
+
+	memset(&s, 0, sizeof(s));
+	s.data = csv->file.data;
+	s.line_number = 1;
+	split(&s, csv->file.size);
+	if (s.failed) {
+		fprintf(stderr, "Failed to allocate memory for %s: %s\n", filename, strerror(errno));
+		free(s.offsets.items);
+		free(s.rows.items);
+		free(s.line_numbers.items);
+		unmap_file(&csv->file);
+		free(csv);
+		return NULL;
 	}
+	csv->offsets = s.offsets.items;
+	csv->rows = s.rows.items;
+	csv->line_numbers = s.line_numbers.items;
+	csv->row_count = s.rows.count - 1;
 	return csv;
 }
 
 void csv_close(struct csv_file* csv) {
-	if (csv->file != NULL && fclose(csv->file) != 0) {
-		fprintf(stderr, "WARNING: Failed to close %s: %s\n", csv->filename, strerror(errno));
-	}
-	if (csv->line != NULL) free(csv->line);
+	free(csv->offsets);
+	free(csv->rows);
+	free(csv->line_numbers);
+	unmap_file(&csv->file);
 	free(csv);
 }
 
-/* Anything after a '#' character is treated as a comment and ignored */
-bool csv_read_line(struct csv_file* csv) {
-	int c;
-	csv->line_number++;
-	csv->column_number = 0;
-	csv->line_length = 0;
-	while ((c = fgetc(csv->file)), c != EOF && c != '\n') {
-		if (c == '#') {
-			while ((c = fgetc(csv->file)) != EOF && c != '\n');
+size_t csv_row_width(struct csv_file const* csv, size_t row) {
+	return csv->rows[row + 1] - csv->rows[row] - 1;
+}
+
+bool csv_get_field(struct csv_file const* csv, size_t row, size_t column,
+                   struct csv_field* field) {
+	uint32_t const* offsets;
+	if (column >= csv_row_width(csv, row)) {
+		/* The end of the last field. */
+		field->data = csv->file.data + csv->offsets[csv->rows[row + 1] - 1] - 1;
+		field->length = 0;
+		return false;
+	}
+	offsets = csv->offsets + csv->rows[row];
+	field->data = csv->file.data + offsets[column];
+	field->length = offsets[column + 1] - 1 - offsets[column];
+	return true;
+}
+
+/* Column of the field in the line, counting from 0, for messages. */
+static size_t column_number(struct csv_file const* csv, size_t row,
+                            struct csv_field const* field) {
+	return (size_t) (field->data - csv->file.data) - csv->offsets[csv->rows[row]];
+}
+
+/* Converts the leading digits of the field, as strtoul would for the plain
+ * numbers these files hold, without copying it. `invalid` is set to the first
+ * byte that is not a digit, or NULL. */
+static bool convert_unsigned(struct csv_file const* csv, size_t row,
+                             struct csv_field const* field,
+                             unsigned long max, char const* type,
+                             unsigned long* value, char const** invalid) {
+	char const* cur = field->data;
+	char const* end = field->data + field->length;
+	*value = 0;
+	*invalid = NULL;
+	for (; cur != end; cur++) {
+		unsigned long digit = (unsigned long) (*cur - '0');
+		if (*cur < '0' || *cur > '9') {
+			*invalid = cur;
 			break;
 		}
-		if (csv->line_length + 1 >= csv->line_capacity) {
-			csv->line_capacity *= 2;
-			csv->line = realloc(csv->line, csv->line_capacity);
-			if (csv->line == NULL) {
-				fprintf(stderr, "Failed to allocate memory for %s: %s\n", csv->filename, strerror(errno));
-				return false;
-			}
+		if (*value > (max - digit) / 10) {
+			fprintf(stderr, "Failed to convert '%.*s' to %s at %s:%lu:%zu: %s\n",
+				(int) field->length, field->data, type,
+				csv->filename, (unsigned long) csv->line_numbers[row],
+				column_number(csv, row, field), "Value out of range");
+			return false;
 		}
-		csv->line[csv->line_length++] = (char) c;
+		*value = *value * 10 + digit;
 	}
-	if (c == EOF && csv->line_length == 0) {
+	return true;
+}
+
+static bool get_number_field(struct csv_file const* csv, size_t row,
+                             size_t column, struct csv_field* field,
+                             char const* type) {
+	if (!csv_get_field(csv, row, column, field)) {
+		fprintf(stderr, "Failed to convert '' to %s at %s:%lu:%zu: %s\n",
+			type, csv->filename, (unsigned long) csv->line_numbers[row],
+			column_number(csv, row, field), "Missing field");
 		return false;
 	}
-	if (csv->line_length + 1 >= csv->line_capacity) {
-		csv->line_capacity *= 2;
-		csv->line = reallocarray(csv->line, csv->line_capacity, 1);
-		if (csv->line == NULL) {
-			fprintf(stderr, "Failed to allocate memory for %s: %s\n", csv->filename,
-				strerror(errno));
-			return false;
-		}
-	}
-	csv->line[csv->line_length] = '\0';
 	return true;
 }
 
-bool csv_read_uint(struct csv_file* csv, unsigned int* value) {
-	bool success = true;
-	char const* token_start = csv->line + csv->column_number;
-	char const* token_end = token_start;
-	char const* token = NULL;
-	unsigned long int conv_value;
-	char* conv_endptr;
-	while (*token_end != '\0' && *token_end != ';') token_end++;
-	token = strndup(token_start, token_end - token_start);
-	if (token == NULL) {
-		fprintf(stderr, "Failed to allocate memory for %s: %s\n", csv->filename, strerror(errno));
-	} else {
-		conv_value = strtoul(token_start, &conv_endptr, 10);
-		if (conv_value == ULONG_MAX) {
-			fprintf(stderr, "Failed to convert '%.*s' to unsigned int at %s:%zu:%zu: %s\n",
-				(int) (token_end - token_start), token_start,
-				csv->filename, csv->line_number, csv->column_number,
-				strerror(errno));
-			success = false;
-		}
-		if (conv_endptr != token_end) {
-			fprintf(stderr, "Failed to convert '%.*s' to unsigned int at %s:%zu:%zu: %s\n",
-				(int) (token_end - token_start), token_start,
-				csv->filename, csv->line_number, csv->column_number,
-				"Invalid character");
-			success = false;
-		}
-		if (conv_value > UINT_MAX) {
-			fprintf(stderr, "Failed to convert '%.*s' to unsigned int at %s:%zu:%zu: %s\n",
-				(int) (token_end - token_start), token_start,
-				csv->filename, csv->line_number, csv->column_number,
-				"Value out of range");
-			success = false;
-		}
-		if (success) {
-			csv->column_number += (token_end - token_start) + 1;
-			*value = (unsigned int) conv_value;
-		}
-		free((void*) token);
+bool csv_get_uint(struct csv_file const* csv, size_t row, size_t column,
+                  unsigned int* value) {
+	struct csv_field field;
+	unsigned long conv_value;
+	char const* invalid;
+	if (!get_number_field(csv, row, column, &field, "unsigned int")
+	    || !convert_unsigned(csv, row, &field, UINT_MAX, "unsigned int",
+	                         &conv_value, &invalid)) {
+		return false;
 	}
-	return success;
+	if (invalid != NULL) {
+		fprintf(stderr, "Failed to convert '%.*s' to unsigned int at %s:%lu:%zu: %s\n",
+			(int) field.length, field.data,
+			csv->filename, (unsigned long) csv->line_numbers[row],
+			column_number(csv, row, &field), "Invalid character");
+		return false;
+	}
+	*value = (unsigned int) conv_value;
+	return true;
 }
 
-bool csv_read_uchar(struct csv_file* csv, unsigned char* value) {
-	bool success = true;
-	char const* token_start = csv->line + csv->column_number;
-	char const* token_end = token_start;
-	char const* token = NULL;
-	unsigned long int conv_value;
-	char* conv_endptr;
-	while (*token_end != '\0' && *token_end != ';') token_end++;
-	token = strndup(token_start, token_end - token_start);
-	if (token == NULL) {
-		fprintf(stderr, "Failed to allocate memory for %s: %s\n", csv->filename, strerror(errno));
-	} else {
-		conv_value = strtoul(token_start, &conv_endptr, 10);
-		if (conv_value == ULONG_MAX) {
-			fprintf(stderr, "Failed to convert '%.*s' to unsigned char at %s:%zu:%zu: %s\n",
-				(int) (token_end - token_start), token_start,
-				csv->filename, csv->line_number, csv->column_number,
-				strerror(errno));
-			success = false;
-		}
-		if (conv_endptr != token_end) {
-			fprintf(stderr, "WARNING: Ignoring invalid character '%c' in '%.*s' at %s:%zu:%zu\n",
-				*conv_endptr, (int) (token_end - token_start), token_start,
-				csv->filename, csv->line_number, csv->column_number);
-		}
-		if (conv_value > UCHAR_MAX) {
-			fprintf(stderr, "Failed to convert '%.*s' to unsigned char at %s:%zu:%zu: %s\n",
-				(int) (token_end - token_start), token_start,
-				csv->filename, csv->line_number, csv->column_number,
-				"Value out of range");
-			success = false;
-		}
-		if (success) {
-			csv->column_number += (token_end - token_start) + 1;
-			*value = (unsigned char) conv_value;
-		}
-		free((void*) token);
+bool csv_get_uchar(struct csv_file const* csv, size_t row, size_t column,
+                   unsigned char* value) {
+	struct csv_field field;
+	unsigned long conv_value;
+	char const* invalid;
+	if (!get_number_field(csv, row, column, &field, "unsigned char")
+	    || !convert_unsigned(csv, row, &field, UCHAR_MAX, "unsigned char",
+	                         &conv_value, &invalid)) {
+		return false;
+	}
+	if (invalid != NULL) {
+		fprintf(stderr, "WARNING: Ignoring invalid character '%c' in '%.*s' at %s:%lu:%zu\n",
+			*invalid, (int) field.length, field.data,
+			csv->filename, (unsigned long) csv->line_numbers[row],
+			column_number(csv, row, &field));
 	}
-	return success;
+	*value = (unsigned char) conv_value;
+	return true;
 }
 
-bool csv_read_string(struct csv_file* csv, char** value) {
-	char const* token_start = csv->line + csv->column_number;
-	char const* token_end = token_start;
-	while (*token_end != '\0' && *token_end != ';') token_end++;
-	csv->column_number += (token_end - token_start) + 1;
-	*value = strndup(token_start, token_end - token_start);
-	if (*value == NULL) {
-		fprintf(stderr, "Failed to allocate memory for %s: %s\n", csv->filename, strerror(errno));
+bool csv_get_string(struct csv_file const* csv, size_t row, size_t column,
+                    struct arena* arena, char** value) {
+	struct csv_field field;
+	if (!csv_get_field(csv, row, column, &field)) {
+		fprintf(stderr, "Missing field at %s:%lu:%zu\n",
+			csv->filename, (unsigned long) csv->line_numbers[row],
+			column_number(csv, row, &field));
 		return false;
 	}
+	*value = arena_strndup(arena, field.data, field.length);
 	return true;
-}
\ No newline at end of file
+}
@@ -1,33 +1,56 @@
 #ifndef OV2_CSV_H
 #define OV2_CSV_H
 
+#include "fs.h"
+#include "arena.h"
 #include <stddef.h>
-#include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
 
+/* Reader for the game's ';'-separated files. The file is mapped and split into
+ * rows and fields in one pass when it is opened; fields are handed out as views
+ * into it, nothing is copied unless asked. Anything after a '#' character is
+ * a comment, and lines holding nothing else are left out. */
+
+/* A field of a row, not NUL-terminated. Valid until csv_close. */
+struct csv_field {
+	char const* data;
+	size_t length;
+};
+
 struct csv_file {
 	char const* filename;
-	FILE* file;
-	char* line;
-	size_t line_length;
-	size_t line_capacity;
-	size_t line_number;
-	size_t column_number;
+	struct mapped_file file;
+	/* Offset into the file of the first byte of every field, each row's
+	 * fields followed by one more offset, one past the end of its last field
+	 * plus one. A field ends one byte before the next offset. */
+	uint32_t* offsets;
+	/* The offsets of row i start at offsets[rows[i]]. There is one more
+	 * entry than there are rows. */
+	uint32_t* rows;
+	/* The line each row is on, counting from 1. */
+	uint32_t* line_numbers;
+	size_t row_count;
 };
 
 struct csv_file* csv_open(char const* filename);
 void csv_close(struct csv_file* csv);
 
-/* Reads the next line from the file into the csv_file line buffer */
-bool csv_read_line(struct csv_file* csv);
+/* Returns how many fields the row has. */
+size_t csv_row_width(struct csv_file const* csv, size_t row);
+
+/* Returns false, with an empty field, past the end of the row. */
+bool csv_get_field(struct csv_file const* csv, size_t row, size_t column,
+                   struct csv_field* field);
 
-/* Reads the next token from the buffer as an unsigned int */
-bool csv_read_uint(struct csv_file* csv, unsigned int* value);
+bool csv_get_uint(struct csv_file const* csv, size_t row, size_t column,
+                  unsigned int* value);
 
-/* Reads the next token from the buffer as an unsigned char */
-bool csv_read_uchar(struct csv_file* csv, unsigned char* value);
+bool csv_get_uchar(struct csv_file const* csv, size_t row, size_t column,
+                   unsigned char* value);
 
-/* Reads the next token from the buffer as a caller-freed string */
-bool csv_read_string(struct csv_file* csv, char** value);
+/* Gets the field as a NUL-terminated copy in `arena` */
+bool csv_get_string(struct csv_file const* csv, size_t row, size_t column,
+                    struct arena* arena, char** value);
 
 #endif /*OV2_CSV_H*/
@@ -0,0 +1,186 @@
+#include "dds.h"
+#include "fs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The magic, the 124-byte header and, within it, the pixel format. Values
+ * are little-endian. */
+#define DDS_MAGIC_SIZE 4
+#define DDS_HEADER_SIZE 124
+#define DDS_HEIGHT_OFFSET 8
+#define DDS_WIDTH_OFFSET 12
+#define DDS_PIXEL_FLAGS_OFFSET 76
+#define DDS_FOURCC_OFFSET 80
+#define DDPF_FOURCC 0x4
+
+static uint32_t read_u32(unsigned char const* data) {
+	return (uint32_t) data[0] | (uint32_t) data[1] << 8
+	       | (uint32_t) data[2] << 16 | (uint32_t) data[3] << 24;
+}
+
+static size_t block_size(enum dds_format format) {
+	return format == DDS_DXT1 ? 8 : 16;
+}
+
+bool read_dds(char const* path, struct dds_image* image) {
+	struct mapped_file file;
+	unsigned char const* header;
+	size_t blocks_count;
+	memset(image, 0, sizeof(struct dds_image));
+	if (!map_file(path, &file)) return false;
+	header = (unsigned char const*) file.data + DDS_MAGIC_SIZE;
+	if (file.size < DDS_MAGIC_SIZE + DDS_HEADER_SIZE
+	    || memcmp(file.data, "DDS ", DDS_MAGIC_SIZE) != 0
+	    || read_u32(header) != DDS_HEADER_SIZE
+	    || !(read_u32(header + DDS_PIXEL_FLAGS_OFFSET) & DDPF_FOURCC)) {
+		unmap_file(&file);
+		return false;
+	}
+	if (memcmp(header + DDS_FOURCC_OFFSET, "DXT1", 4) == 0) {
+		image->format = DDS_DXT1;
+	} else if (memcmp(header + DDS_FOURCC_OFFSET, "DXT3", 4) == 0) {
+		image->format = DDS_DXT3;
+	} else if (memcmp(header + DDS_FOURCC_OFFSET, "DXT5", 4) == 0) {
+		image->format = DDS_DXT5;
+	} else {
+		unmap_file(&file);
+		return false;
+	}
+	image->width = read_u32(header + DDS_WIDTH_OFFSET);
+	image->height = read_u32(header + DDS_HEIGHT_OFFSET);
+	blocks_count = (size_t) ((image->width + 3) / 4) * ((image->height + 3) / 4);
+	if (image->width == 0 || image->height == 0 || image->width > 16384
+	    || image->height > 16384
+	    || blocks_count * block_size(image->format)
+	       > file.size - DDS_MAGIC_SIZE - DDS_HEADER_SIZE) {
+		fprintf(stderr, "Invalid DDS file %s\n", path);
+		unmap_file(&file);
+		return false;
+	}
+	image->size = blocks_count * block_size(image->format);
+	if ((image->blocks = malloc(image->size)) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for %s.\n", path);
+		unmap_file(&file);
+		return false;
+	}
+	memcpy(image->blocks, file.data + DDS_MAGIC_SIZE + DDS_HEADER_SIZE, image->size);
+	unmap_file(&file);
+	return true;
+}
+
+void free_dds(struct dds_image* image) {
+	free(image->blocks);
+	memset(image, 0, sizeof(struct dds_image));
+}
+
+/* region decoder */
+
+static void expand_565(unsigned int color, unsigned char* rgba) {
+	unsigned int r = (color >> 11) & 31;
+	unsigned int g = (color >> 5) & 63;
+	unsigned int b = color & 31;
+	rgba[0] = (unsigned char) (r << 3 | r >> 2);
+	rgba[1] = (unsigned char) (g << 2 | g >> 4);
+	rgba[2] = (unsigned char) (b << 3 | b >> 2);
+	rgba[3] = 255;
+}
+
+/* The 16 pixels of a color block, DXT1's 3-color mode with a transparent
+ * black only when `allow_transparent`, as DXT3 and DXT5 always use 4. */
+static void decode_color_block(unsigned char const* block, bool allow_transparent,
+                               unsigned char pixels[16][4]) {
+	unsigned int c0 = (unsigned int) block[0] | (unsigned int) block[1] << 8;
+	unsigned int c1 = (unsigned int) block[2] | (unsigned int) block[3] << 8;
+	uint32_t indices = read_u32(block + 4);
+	unsigned char palette[4][4];
+	int i, channel;
+	expand_565(c0, palette[0]);
+	expand_565(c1, palette[1]);
+	for (channel = 0; channel < 3; channel++) {
+		if (c0 > c1 || !allow_transparent) {
+			palette[2][channel] = (unsigned char) ((2 * palette[0][channel] + palette[1][channel]) / 3);
+			palette[3][channel] = (unsigned char) ((palette[0][channel] + 2 * palette[1][channel]) / 3);
+		} else {
+			palette[2][channel] = (unsigned char) ((palette[0][channel] + palette[1][channel]) / 2);
+			palette[3][channel] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = c0 > c1 || !allow_transparent ? 255 : 0;
+	for (i = 0; i < 16; i++) {
+		memcpy(pixels[i], palette[(indices >> (2 * i)) & 3], 4);
+	}
+}
+
+/* Explicit 4-bit alpha, lowest bits first. */
+static void decode_dxt3_alpha(unsigned char const* block, unsigned char pixels[16][4]) {
+	int i;
+	for (i = 0; i < 16; i++) {
+		unsigned int alpha = (block[i / 2] >> (4 * (i % 2))) & 15;
+		pixels[i][3] = (unsigned char) (alpha << 4 | alpha);
+	}
+}
+
+/* Two end points and a 3-bit index per pixel into 6 or 8 levels between
+ * them. */
+static void decode_dxt5_alpha(unsigned char const* block, unsigned char pixels[16][4]) {
+	unsigned int a0 = block[0];
+	unsigned int a1 = block[1];
+	uint64_t indices = 0;
+	unsigned char levels[8];
+	int i;
+	for (i = 0; i < 6; i++) {
+		indices |= (uint64_t) block[2 + i] << (8 * i);
+	}
+	levels[0] = (unsigned char) a0;
+	levels[1] = (unsigned char) a1;
+	if (a0 > a1) {
+		for (i = 1; i < 7; i++) {
+			levels[i + 1] = (unsigned char) (((7 - i) * a0 + i * a1) / 7);
+		}
+	} else {
+		for (i = 1; i < 5; i++) {
+			levels[i + 1] = (unsigned char) (((5 - i) * a0 + i * a1) / 5);
+		}
+		levels[6] = 0;
+		levels[7] = 255;
+	}
+	for (i = 0; i < 16; i++) {
+		pixels[i][3] = levels[(indices >> (3 * i)) & 7];
+	}
+}
+
+void decode_dds(struct dds_image const* image, unsigned char* rgba) {
+	unsigned char const* block = image->blocks;
+	uint32_t block_x, block_y;
+	for (block_y = 0; block_y < image->height; block_y += 4) {
+		for (block_x = 0; block_x < image->width; block_x += 4) {
+			unsigned char pixels[16][4];
+			uint32_t x, y;
+			switch (image->format) {
+			case DDS_DXT1:
+				decode_color_block(block, true, pixels);
+				break;
+			case DDS_DXT3:
+				decode_color_block(block + 8, false, pixels);
+				decode_dxt3_alpha(block, pixels);
+				break;
+			case DDS_DXT5:
+				decode_color_block(block + 8, false, pixels);
+				decode_dxt5_alpha(block, pixels);
+				break;
+			}
+			block += block_size(image->format);
+			/* Blocks at the right and bottom edges may hang over. */
+			for (y = 0; y < 4 && block_y + y < image->height; y++) {
+				for (x = 0; x < 4 && block_x + x < image->width; x++) {
+					memcpy(rgba + (((size_t) block_y + y) * image->width + block_x + x) * 4,
+					       pixels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+}
+
+/* endregion */
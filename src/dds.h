@@ -0,0 +1,34 @@
+#ifndef OV2_DDS_H
+#define OV2_DDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+enum dds_format {
+	DDS_DXT1,
+	DDS_DXT3,
+	DDS_DXT5
+};
+
+/* The first mipmap level of a DXT-compressed DDS file, blocks of 4 by 4
+ * pixels row by row from the top, as GL takes them. */
+struct dds_image {
+	enum dds_format format;
+	uint32_t width;
+	uint32_t height;
+	unsigned char* blocks;
+	size_t size;
+};
+
+/* Reads the DDS file at `path`. Returns false if it can not be read, or is not
+ * DXT1, DXT3 or DXT5, which is left to other loaders. */
+bool read_dds(char const* path, struct dds_image* image);
+
+void free_dds(struct dds_image* image);
+
+/* Decodes the blocks into `rgba`, 4 bytes for each of the width by height
+ * pixels. */
+void decode_dds(struct dds_image const* image, unsigned char* rgba);
+
+#endif /*OV2_DDS_H*/
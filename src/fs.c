@@ -1,7 +1,198 @@
 #include "fs.h"
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
 
 bool has_ext(char const* path, char const* ext) {
 	path = strrchr(path, '.');
 	return path && !strcmp(path, ext);
-}
\ No newline at end of file
+}
+
+#ifdef _WIN32
+
+bool map_file(char const* path, struct mapped_file* file) {
+	FILE* fp = fopen(path, "rb");
+	char* data = NULL;
+	long size;
+	file->data = NULL;
+	file->size = 0;
+	if (fp == NULL) return false;
+	if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0
+	    || fseek(fp, 0, SEEK_SET) != 0) {
+		fclose(fp);
+		return false;
+	}
+	if (size > 0) {
+		if ((data = malloc((size_t) size)) == NULL) {
+			fclose(fp);
+			return false;
+		}
+		if (fread(data, 1, (size_t) size, fp) != (size_t) size) {
+			free(data);
+			fclose(fp);
+			errno = EIO;
+			return false;
+		}
+	}
+	fclose(fp);
+	file->data = data;
+	file->size = (size_t) size;
+	return true;
+}
+
+void unmap_file(struct mapped_file* file) {
+	free((void*) file->data);
+	file->data = NULL;
+	file->size = 0;
+}
+
+void release_mapped_prefix(struct mapped_file* file, size_t offset) {
+	(void) file;
+	(void) offset;
+}
+
+#else
+
+bool map_file(char const* path, struct mapped_file* file) {
+	struct stat st;
+	void* data;
+	int fd = open(path, O_RDONLY);
+	file->data = NULL;
+	file->size = 0;
+	if (fd < 0) return false;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+	/* mmap refuses empty mappings, an empty file is just an empty view. */
+	if (st.st_size > 0) {
+		data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+		file->data = data;
+		file->size = (size_t) st.st_size;
+	}
+	close(fd);
+	return true;
+}
+
+void unmap_file(struct mapped_file* file) {
+	if (file->data != NULL) munmap((void*) file->data, file->size);
+	file->data = NULL;
+	file->size = 0;
+}
+
+void release_mapped_prefix(struct mapped_file* file, size_t offset) {
+	size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+	size_t length = offset - offset % page_size;
+	/* The mapping is private and never written, so discarded pages are
+	 * faulted back in from the file. */
+	if (file->data != NULL && length > 0) {
+		madvise((void*) file->data, length, MADV_DONTNEED);
+	}
+}
+
+#endif
+
+/* FNV-1a */
+uint64_t hash_bytes(char const* data, size_t size) {
+	uint64_t hash = UINT64_C(14695981039346656037);
+	size_t i;
+	for (i = 0; i < size; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+bool hash_file(char const* path, uint64_t* hash) {
+	struct mapped_file file;
+	if (!map_file(path, &file)) return false;
+	*hash = hash_bytes(file.data, file.size);
+	unmap_file(&file);
+	return true;
+}
+
+bool stamp_file(char const* path, struct file_stamp* stamp) {
+	struct stat st;
+	if (stat(path, &st) != 0 || !hash_file(path, &stamp->hash)) return false;
+	stamp->size = (uint64_t) st.st_size;
+	stamp->mtime = (int64_t) st.st_mtime;
+	return true;
+}
+
+/* A file whose mtime changed is still the same if its contents did not. */
+bool is_file_unchanged(char const* path, struct file_stamp const* stamp) {
+	struct stat st;
+	uint64_t hash;
+	if (stat(path, &st) != 0 || (uint64_t) st.st_size != stamp->size) return false;
+	return (int64_t) st.st_mtime == stamp->mtime
+	       || (hash_file(path, &hash) && hash == stamp->hash);
+}
+
+bool stamp_files(char const* const* files, size_t files_count, struct file_stamp* stamps) {
+	size_t i;
+	for (i = 0; i < files_count; i++) {
+		if (!stamp_file(files[i], &stamps[i])) {
+			fprintf(stderr, "Failed to read '%s': %s\n", files[i], strerror(errno));
+			return false;
+		}
+	}
+	return true;
+}
+
+bool are_files_unchanged(char const* const* files, size_t files_count,
+                         struct file_stamp const* stamps) {
+	size_t i;
+	for (i = 0; i < files_count; i++) {
+		if (!is_file_unchanged(files[i], &stamps[i])) return false;
+	}
+	return true;
+}
+
+bool write_file_atomically(char const* path, struct file_part const* parts, size_t parts_count) {
+	char* tmp_path = malloc(strlen(path) + strlen(".tmp") + 1);
+	FILE* fp;
+	bool success = true;
+	size_t i;
+	if (tmp_path == NULL) {
+		fprintf(stderr, "Failed to allocate memory for path.\n");
+		return false;
+	}
+	strcpy(tmp_path, path);
+	strcat(tmp_path, ".tmp");
+	if ((fp = fopen(tmp_path, "wb")) == NULL) {
+		fprintf(stderr, "Failed to open file '%s': %s\n", tmp_path, strerror(errno));
+		free(tmp_path);
+		return false;
+	}
+	for (i = 0; success && i < parts_count; i++) {
+		if (fwrite(parts[i].data, 1, parts[i].size, fp) != parts[i].size) {
+			fprintf(stderr, "Failed to write file '%s': %s\n", tmp_path, strerror(errno));
+			success = false;
+		}
+	}
+	if (fclose(fp) != 0) {
+		success = false;
+	}
+#ifdef _WIN32
+	if (success) remove(path);
+#endif
+	if (success && rename(tmp_path, path) != 0) {
+		fprintf(stderr, "Failed to rename '%s' to '%s': %s\n", tmp_path, path,
+		        strerror(errno));
+		success = false;
+	}
+	if (!success) remove(tmp_path);
+	free(tmp_path);
+	return success;
+}
@@ -7,7 +7,63 @@
 #include <dirent.h>
 #endif
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A read-only view of a whole file. `data` is not NUL-terminated. */
+struct mapped_file {
+	char const* data;
+	size_t size;
+};
 
 bool has_ext(char const* path, char const* ext);
 
+/* Maps `path` into memory, falling back to reading it in one go where mmap is
+ * not available. Returns false and sets errno on failure. */
+bool map_file(char const* path, struct mapped_file* file);
+
+void unmap_file(struct mapped_file* file);
+
+/* Lets the system drop the pages holding the first `offset` bytes, which are
+ * read back from the file if they are accessed again. Does nothing where the
+ * file was read into memory. */
+void release_mapped_prefix(struct mapped_file* file, size_t offset);
+
+/* Hashes the bytes, to tell whether cached data is still fresh. */
+uint64_t hash_bytes(char const* data, size_t size);
+
+/* Hashes the contents of `path`. Returns false if it can not be read. */
+bool hash_file(char const* path, uint64_t* hash);
+
+/* What a cache remembers of a file it was built from. */
+struct file_stamp {
+	uint64_t size;
+	int64_t mtime;
+	uint64_t hash;
+};
+
+/* Returns false and sets errno if `path` can not be read. */
+bool stamp_file(char const* path, struct file_stamp* stamp);
+
+/* Returns whether `path` still has the contents it had when stamped. */
+bool is_file_unchanged(char const* path, struct file_stamp const* stamp);
+
+/* Stamps each of `files` into `stamps`. Returns false, saying which file
+ * could not be read, on failure. */
+bool stamp_files(char const* const* files, size_t files_count, struct file_stamp* stamps);
+
+bool are_files_unchanged(char const* const* files, size_t files_count,
+                         struct file_stamp const* stamps);
+
+/* A piece of a file to write. */
+struct file_part {
+	void const* data;
+	size_t size;
+};
+
+/* Writes the parts one after the other to `path`, through a file next to it
+ * that is moved over it once complete, so that a crash never leaves a
+ * truncated file behind. Returns false, saying why, on failure. */
+bool write_file_atomically(char const* path, struct file_part const* parts, size_t parts_count);
+
 #endif /*OV2_FS_H*/
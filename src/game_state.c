@@ -1,40 +1,252 @@
 #include "game_state.h"
 #include "province_definitions.h"
+#include "province_map.h"
+#include "adjacency.h"
+#include "province_geometry.h"
 #include "parse.h"
 #include "fs.h"
 #include "localization.h"
+#include "workers.h"
+#include "interface_cache.h"
+#include "texture.h"
+#include "vfs.h"
 #include <GL/gl.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 #include <SOIL/SOIL.h>
+#include <SDL2/SDL.h>
 #include <assert.h>
 
-struct game_state* init_game_state(int32_t window_width, int32_t window_height) {
+struct interface_file {
+	char const* path;
+	struct arena arena;
+	struct sprite_list sprites;
+	struct ui_widget_list widgets;
+	struct bitmap_font_list bitmap_fonts;
+	struct font_list fonts;
+};
+
+static void parse_interface_file(void* data, size_t index) {
+	struct interface_file* file = (struct interface_file*) data + index;
+	parse(file->path, &file->arena, &file->sprites, &file->widgets,
+	      &file->bitmap_fonts, &file->fonts);
+}
+
+/* Parses the files on the worker pool, each into its own lists. The lists are
+ * concatenated in the order of `paths`, so lookups resolve exactly as if the
+ * files had been parsed one after another. */
+static bool parse_interface(struct game_state* state, char* const* paths, size_t paths_count) {
+	struct interface_file* files = calloc(paths_count + 1, sizeof(struct interface_file));
+	size_t sprites_count = 0;
+	size_t widgets_count = 0;
+	size_t bitmap_fonts_count = 0;
+	size_t fonts_count = 0;
+	size_t i;
+
+	if (files == NULL) {
+		fprintf(stderr, "Failed to allocate memory for interface files.\n");
+		return false;
+	}
+	for (i = 0; i < paths_count; i++) {
+		files[i].path = paths[i];
+	}
+
+	parallel_for(paths_count, parse_interface_file, files);
+
+	for (i = 0; i < paths_count; i++) {
+		sprites_count += files[i].sprites.count;
+		widgets_count += files[i].widgets.count;
+		bitmap_fonts_count += files[i].bitmap_fonts.count;
+		fonts_count += files[i].fonts.count;
+	}
+	state->sprites.items = arena_alloc(&state->ui_arena, sprites_count * sizeof(struct sprite));
+	state->widgets.items = arena_alloc(&state->ui_arena, widgets_count * sizeof(struct ui_widget));
+	state->bitmap_fonts.items = arena_alloc(&state->ui_arena, bitmap_fonts_count * sizeof(struct bitmap_font));
+	state->fonts.items = arena_alloc(&state->ui_arena, fonts_count * sizeof(struct font));
+	for (i = 0; i < paths_count; i++) {
+		struct interface_file* file = &files[i];
+		memcpy(state->sprites.items + state->sprites.count, file->sprites.items,
+		       file->sprites.count * sizeof(struct sprite));
+		state->sprites.count += file->sprites.count;
+		memcpy(state->widgets.items + state->widgets.count, file->widgets.items,
+		       file->widgets.count * sizeof(struct ui_widget));
+		state->widgets.count += file->widgets.count;
+		memcpy(state->bitmap_fonts.items + state->bitmap_fonts.count, file->bitmap_fonts.items,
+		       file->bitmap_fonts.count * sizeof(struct bitmap_font));
+		state->bitmap_fonts.count += file->bitmap_fonts.count;
+		memcpy(state->fonts.items + state->fonts.count, file->fonts.items,
+		       file->fonts.count * sizeof(struct font));
+		state->fonts.count += file->fonts.count;
+		arena_merge(&state->ui_arena, &file->arena);
+	}
+	free(files);
+	return true;
+}
+
+/* Loads every .gfx and .gui file in interface/, from the interface cache when
+ * it is still fresh and by parsing them otherwise. */
+static bool load_interface(struct game_state* state) {
+	bool success = true;
+	struct asset const* asset;
+	char** paths = NULL;
+	size_t paths_count = 0;
+	size_t paths_capacity = 0;
+	size_t i;
+
+	if ((asset = list_assets("interface")) == NULL) {
+		fprintf(stderr, "No interface files found\n");
+		return false;
+	}
+	for (; asset != NULL; asset = asset->next) {
+		char* path;
+		if (asset->is_directory) continue;
+		if (!has_ext(asset->name, ".gfx") && !has_ext(asset->name, ".gui")) continue;
+		if (paths_count == paths_capacity) {
+			size_t new_capacity = paths_capacity == 0 ? 64 : paths_capacity * 2;
+			char** new_paths = realloc(paths, new_capacity * sizeof(char*));
+			if (new_paths == NULL) {
+				fprintf(stderr, "Failed to allocate memory for interface files.\n");
+				success = false;
+				break;
+			}
+			paths = new_paths;
+			paths_capacity = new_capacity;
+		}
+		if ((path = malloc(strlen(asset->path) + 1)) == NULL) {
+			fprintf(stderr, "Failed to allocate memory for path.\n");
+			success = false;
+			break;
+		}
+		strcpy(path, asset->path);
+		paths[paths_count++] = path;
+	}
+
+	if (success && !load_interface_cache(
+		INTERFACE_CACHE_PATH, paths, paths_count, &state->ui_arena,
+		&state->sprites, &state->widgets, &state->bitmap_fonts, &state->fonts
+	) && (success = parse_interface(state, paths, paths_count))) {
+		if (!save_interface_cache(INTERFACE_CACHE_PATH, paths, paths_count,
+		                          &state->sprites, &state->widgets,
+		                          &state->bitmap_fonts, &state->fonts)) {
+			fprintf(stderr, "WARNING: Failed to write %s.\n", INTERFACE_CACHE_PATH);
+		}
+	}
+
+	for (i = 0; i < paths_count; i++) {
+		free(paths[i]);
+	}
+	free(paths);
+	return success;
+}
+
+/* Decodes map/provinces.bmp once, uploading it as the provinces texture and
+ * looking up the province of every pixel by its color. */
+static bool load_province_map(struct game_state* state) {
+	char const* path;
+	unsigned char* pixels;
+	int width, height, channels;
+	bool success = true;
+
+	if ((path = find_asset("map/provinces.bmp")) == NULL) {
+		fprintf(stderr, "Failed to find map/provinces.bmp\n");
+		return false;
+	}
+	if ((pixels = SOIL_load_image(
+		path,
+		&width,
+		&height,
+		&channels,
+		SOIL_LOAD_RGBA
+	)) == NULL) {
+		fprintf(stderr, "SOIL loading error while loading texture %s: "
+				"%s\n", path, SOIL_last_result());
+		return false;
+	}
+	if ((state->provinces_texture = SOIL_create_OGL_texture(
+		pixels,
+		width,
+		height,
+		4,
+		SOIL_CREATE_NEW_ID,
+		0
+	)) == 0) {
+		fprintf(stderr, "SOIL loading error while loading texture %s: "
+				"%s\n", path, SOIL_last_result());
+		success = false;
+	} else {
+		success = build_province_map(
+			&state->provinces, pixels, (uint32_t) width, (uint32_t) height,
+			&state->province_map
+		);
+	}
+
+	SOIL_free_image_data(pixels);
+	return success;
+}
+
+/* Finds the neighbours of every province from the province map and
+ * map/adjacencies.csv, if there is one, or takes them from the adjacency cache
+ * when it is still fresh. */
+static bool load_adjacency(struct game_state* state) {
+	char const* sources[3];
+	size_t sources_count = 3;
+
+	/* The first two were found loading the definitions and province map. */
+	sources[0] = find_asset("map/provinces.bmp");
+	sources[1] = find_asset("map/definition.csv");
+	if ((sources[2] = find_asset("map/adjacencies.csv")) == NULL) sources_count = 2;
+	if (load_adjacency_cache(ADJACENCY_CACHE_PATH, sources, sources_count,
+	                         state->provinces.count, &state->adjacency)) {
+		return true;
+	}
+	if (!build_province_adjacency(&state->provinces, &state->province_map,
+	                              sources_count == 3 ? sources[2] : NULL,
+	                              &state->adjacency)) {
+		return false;
+	}
+	if (!save_adjacency_cache(ADJACENCY_CACHE_PATH, sources, sources_count,
+	                          &state->adjacency)) {
+		fprintf(stderr, "WARNING: Failed to write %s.\n", ADJACENCY_CACHE_PATH);
+	}
+	return true;
+}
+
+struct game_state* init_game_state(
+	int32_t window_width,
+	int32_t window_height,
+	char const* const* roots,
+	size_t roots_count
+) {
 	bool success = true;
-	struct game_state* state = malloc(sizeof(struct game_state));
+	struct game_state* state = calloc(1, sizeof(struct game_state));
 	if (state == NULL) {
 		fprintf(stderr, "Failed to allocate memory for game state.\n");
+	} else if (!index_assets(roots, roots_count)) {
+		fprintf(stderr, "Failed to index the game's files.\n");
+		success = false;
 	} else if (load_province_definitions(
-		&state->province_definitions,
-		&state->province_definitions_count
-	), state->province_definitions == NULL) {
+		&state->data_arena,
+		&state->provinces
+	), state->provinces.items == NULL) {
 		fprintf(stderr, "Failed to load province definitions.\n");
 		success = false;
 	} else if (load_localizations(
 		&state->localizations,
-		&state->localizations_count
-	), state->localizations == NULL) {
+		LANGUAGE_ENGLISH
+	), state->localizations.items == NULL) {
 		fprintf(stderr, "Failed to load localizations.\n");
 		success = false;
-	} else if ((state->provinces_texture = SOIL_load_OGL_texture(
-		"map/provinces.bmp",
-		SOIL_LOAD_RGBA,
-		SOIL_CREATE_NEW_ID,
-		0
-	)) == 0) {
-		fprintf(stderr, "SOIL loading error while loading texture %s: "
-				"%s\n", "map/provinces.bmp", SOIL_last_result());
+	} else if (!load_province_map(state)) {
+		success = false;
+	} else if (!load_adjacency(state)) {
+		fprintf(stderr, "Failed to find the province adjacencies.\n");
+		success = false;
+	} else if (!build_province_geometry(
+		&state->province_map,
+		state->provinces.count,
+		&state->province_geometry
+	)) {
 		success = false;
 	} else {
 		state->current_window = WINDOW_MAP;
@@ -50,40 +262,17 @@ struct game_state* init_game_state(int32_t window_width, int32_t window_height)
 		state->window_width = window_width;
 		state->window_height = window_height;
 		state->should_quit = false;
-		state->widgets = NULL;
-		state->sprites = NULL;
-		state->bitmap_fonts = NULL;
-		state->fonts = NULL;
+		state->ui_arena.blocks = NULL;
+		state->widgets = (struct ui_widget_list){NULL, 0};
+		state->sprites = (struct sprite_list){NULL, 0};
+		state->bitmap_fonts = (struct bitmap_font_list){NULL, 0};
+		state->fonts = (struct font_list){NULL, 0};
 		state->last_game_tick_time = 0;
 
-		{
-			/* load game data */
-			DIR* dir;
-			struct dirent* entry;
-			if ((dir = opendir("interface")) == NULL) {
-				fprintf(stderr, "Failed to open interface directory\n");
-				success = false;
-			} else {
-				while ((entry = readdir(dir)) != NULL) {
-					if (entry->d_type == DT_REG) {
-						char* path = malloc(strlen("interface/") + strlen(entry->d_name) + 1);
-						if (path == NULL) {
-							fprintf(stderr, "Failed to allocate memory for path.\n");
-							success = false;
-							break;
-						}
-						strcpy(path, "interface/");
-						strcat(path, entry->d_name);
-						if (has_ext(path, ".gfx") || has_ext(path, ".gui")) {
-							parse(path, &state->sprites, &state->widgets, &state->bitmap_fonts, &state->fonts);
-						}
-						free(path);
-					}
-				}
-				closedir(dir);
-			}
-			localize_ui_widgets(state->widgets, state->localizations, state->localizations_count);
+		if (!load_interface(state)) {
+			success = false;
 		}
+		localize_ui_widgets(state->widgets, &state->localizations);
 	}
 
 	if (!success) {
@@ -95,19 +284,35 @@ struct game_state* init_game_state(int32_t window_width, int32_t window_height)
 }
 
 void free_game_state(struct game_state* game_state) {
-	free_province_definitions(
-		game_state->province_definitions,
-		game_state->province_definitions_count
-	);
-	free_localizations(
-		game_state->localizations,
-		game_state->localizations_count
-	);
-	free_sprites(game_state->sprites);
-	free_widgets(game_state->widgets);
-	free_bitmap_fonts(game_state->bitmap_fonts);
-	free_fonts(game_state->fonts);
+	free_localizations(&game_state->localizations);
+	free_province_geometry(&game_state->province_geometry);
+	free_province_adjacency(&game_state->adjacency);
+	free_province_map(&game_state->province_map);
+	arena_free(&game_state->data_arena);
+	arena_free(&game_state->ui_arena);
 	glDeleteTextures(1, &game_state->provinces_texture);
+	free_textures();
+	free_asset_index();
 
 	free(game_state);
-}
\ No newline at end of file
+}
+
+bool set_language(struct game_state* state, enum language language) {
+	if (!set_localization_language(&state->localizations, language)) {
+		return false;
+	}
+	/* The widget texts were replaced by their localization, the keys are
+	 * loaded again with the rest of the interface, from the cache. */
+	arena_free(&state->ui_arena);
+	state->widgets = (struct ui_widget_list){NULL, 0};
+	state->sprites = (struct sprite_list){NULL, 0};
+	state->bitmap_fonts = (struct bitmap_font_list){NULL, 0};
+	state->fonts = (struct font_list){NULL, 0};
+	if (!load_interface(state)) {
+		fprintf(stderr, "Failed to reload the interface.\n");
+		state->should_quit = true;
+		return false;
+	}
+	localize_ui_widgets(state->widgets, &state->localizations);
+	return true;
+}
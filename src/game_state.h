@@ -2,6 +2,11 @@
 #define OV2_GAME_STATE_H
 
 #include "parse.h"
+#include "localization.h"
+#include "province_definitions.h"
+#include "province_map.h"
+#include "adjacency.h"
+#include "province_geometry.h"
 #include <stdlib.h>
 #include <GL/gl.h>
 
@@ -19,10 +24,13 @@ enum current_window {
 
 /* TODO: Separate into actual game state and UI state. */
 struct game_state {
-	size_t localizations_count;
-	struct localization* localizations;
-	size_t province_definitions_count;
-	struct province_definition* province_definitions;
+	/* Owns the province definitions and their names. */
+	struct arena data_arena;
+	struct localization_table localizations;
+	struct province_table provinces;
+	struct province_map province_map;
+	struct province_adjacency adjacency;
+	struct province_geometry province_geometry;
 
 	enum current_window current_window;
 	bool is_paused;
@@ -38,16 +46,31 @@ struct game_state {
 	bool should_quit;
 	uint32_t last_game_tick_time;
 
-	struct sprite* sprites;
-	struct ui_widget* widgets;
-	struct bitmap_font* bitmap_fonts;
-	struct font* fonts;
+	/* Owns every sprite, widget and font definition below. */
+	struct arena ui_arena;
+	struct sprite_list sprites;
+	struct ui_widget_list widgets;
+	struct bitmap_font_list bitmap_fonts;
+	struct font_list fonts;
 
 	GLuint provinces_texture;
 };
 
-struct game_state* init_game_state(int32_t window_width, int32_t window_height);
+/* Reads the game's files from `roots`, the game's directory followed by any
+ * mods, each overriding the files of the ones before. */
+struct game_state* init_game_state(
+	int32_t window_width,
+	int32_t window_height,
+	char const* const* roots,
+	size_t roots_count
+);
 
 void free_game_state(struct game_state* game_state);
 
+/* Switches the localizations and the interface to `language`. Returns false,
+ * keeping the current language, if the localization files can not be read
+ * again. Also returns false if the interface can not be loaded again, which
+ * leaves the game without one and sets `should_quit`. */
+bool set_language(struct game_state* state, enum language language);
+
 #endif /*OV2_GAME_STATE_H*/
@@ -0,0 +1,581 @@
+#include "interface_cache.h"
+#include "fs.h"
+#include "intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+/* The cache is a header followed by tables addressed by byte offsets from the
+ * start of the file, each aligned to CACHE_ALIGNMENT:
+ *
+ *  - the interface files it was built from, with their size, mtime and hash,
+ *  - the distinct strings, as offset and length of NUL-terminated text,
+ *  - the sprites, widgets, bitmap fonts, colour codes and fonts, stored as in
+ *    memory, with string fields replaced by their string index plus one (zero
+ *    for NULL) and list items by the index of the first item.
+ *
+ * Widgets are stored breadth first, the root widgets come first and every
+ * list of children is contiguous. */
+
+#define CACHE_MAGIC 0x4932564fu /* "OV2I" */
+/* Bump whenever the parsed structures change in a way their sizes do not. */
+#define CACHE_VERSION 1
+#define CACHE_ALIGNMENT 16
+
+struct cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t pointer_size;
+	uint32_t sprite_size;
+	uint32_t widget_size;
+	uint32_t bitmap_font_size;
+	uint32_t color_code_size;
+	uint32_t font_size;
+	uint64_t files_count;
+	uint64_t files_offset;
+	uint64_t strings_count;
+	uint64_t strings_offset;
+	uint64_t sprites_count;
+	uint64_t sprites_offset;
+	uint64_t root_widgets_count;
+	uint64_t widgets_count;
+	uint64_t widgets_offset;
+	uint64_t bitmap_fonts_count;
+	uint64_t bitmap_fonts_offset;
+	uint64_t color_codes_count;
+	uint64_t color_codes_offset;
+	uint64_t fonts_count;
+	uint64_t fonts_offset;
+};
+
+struct cache_file {
+	uint64_t path;
+	struct file_stamp stamp;
+};
+
+struct cache_string {
+	uint64_t offset;
+	uint64_t length;
+};
+
+static void init_header(struct cache_header* header) {
+	memset(header, 0, sizeof(struct cache_header));
+	header->magic = CACHE_MAGIC;
+	header->version = CACHE_VERSION;
+	header->pointer_size = sizeof(void*);
+	header->sprite_size = sizeof(struct sprite);
+	header->widget_size = sizeof(struct ui_widget);
+	header->bitmap_font_size = sizeof(struct bitmap_font);
+	header->color_code_size = sizeof(struct color_code);
+	header->font_size = sizeof(struct font);
+}
+
+static struct ui_widget_list* children_of(struct ui_widget* widget) {
+	switch (widget->type) {
+	case TYPE_WINDOW:
+		return &widget->window.children;
+	case TYPE_SCROLLBAR:
+		return &widget->scrollbar.children;
+	case TYPE_EU3_DIALOG:
+		return &widget->eu3_dialog.children;
+	default:
+		return NULL;
+	}
+}
+
+/* region save */
+
+struct buffer {
+	char* data;
+	size_t size;
+	size_t capacity;
+	bool failed;
+};
+
+/* Returns the offset `data` was appended at. */
+static size_t append(struct buffer* buffer, void const* data, size_t size) {
+	size_t offset = buffer->size;
+	if (buffer->failed) return offset;
+	if (buffer->size + size > buffer->capacity) {
+		size_t capacity = buffer->capacity == 0 ? 65536 : buffer->capacity;
+		char* new_data;
+		while (buffer->size + size > capacity) capacity *= 2;
+		if ((new_data = realloc(buffer->data, capacity)) == NULL) {
+			buffer->failed = true;
+			return offset;
+		}
+		buffer->data = new_data;
+		buffer->capacity = capacity;
+	}
+	memcpy(buffer->data + buffer->size, data, size);
+	buffer->size += size;
+	return offset;
+}
+
+static size_t align(struct buffer* buffer) {
+	static char const zeros[CACHE_ALIGNMENT] = {0};
+	append(buffer, zeros, (CACHE_ALIGNMENT - buffer->size % CACHE_ALIGNMENT) % CACHE_ALIGNMENT);
+	return buffer->size;
+}
+
+struct string_slot {
+	char const* str;
+	uint64_t index;
+};
+
+/* Numbers the distinct strings in the order they are first stored. Strings are
+ * interned, so they are told apart by their address. */
+struct string_table {
+	struct string_slot* slots;
+	size_t capacity;
+	char const** strings;
+	size_t count;
+	bool failed;
+};
+
+static size_t hash_pointer(char const* str, size_t capacity) {
+	uintptr_t value = (uintptr_t) str;
+	value ^= value >> 17;
+	value *= 0x9e3779b9u;
+	return (size_t) (value ^ (value >> 15)) & (capacity - 1);
+}
+
+static bool grow_string_table(struct string_table* table) {
+	size_t capacity = table->capacity == 0 ? 1024 : table->capacity * 2;
+	struct string_slot* slots = calloc(capacity, sizeof(struct string_slot));
+	char const** strings = realloc(table->strings, capacity / 2 * sizeof(char const*));
+	size_t i;
+	if (slots == NULL || strings == NULL) {
+		free(slots);
+		if (strings != NULL) table->strings = strings;
+		return false;
+	}
+	for (i = 0; i < table->capacity; i++) {
+		if (table->slots[i].str != NULL) {
+			size_t slot = hash_pointer(table->slots[i].str, capacity);
+			while (slots[slot].str != NULL) slot = (slot + 1) & (capacity - 1);
+			slots[slot] = table->slots[i];
+		}
+	}
+	free(table->slots);
+	table->slots = slots;
+	table->strings = strings;
+	table->capacity = capacity;
+	return true;
+}
+
+static uint64_t add_string(struct string_table* table, char const* str) {
+	size_t slot;
+	if (table->count >= table->capacity / 2 && !grow_string_table(table)) {
+		table->failed = true;
+		return 0;
+	}
+	slot = hash_pointer(str, table->capacity);
+	while (table->slots[slot].str != NULL) {
+		if (table->slots[slot].str == str) return table->slots[slot].index;
+		slot = (slot + 1) & (table->capacity - 1);
+	}
+	table->slots[slot].str = str;
+	table->slots[slot].index = table->count;
+	table->strings[table->count] = str;
+	return table->count++;
+}
+
+static void store_string(char const** field, void* data) {
+	if (*field != NULL) {
+		uint64_t index = add_string(data, *field);
+		*field = (char const*) (uintptr_t) (index + 1);
+	}
+}
+
+static size_t count_widgets(struct ui_widget_list widgets) {
+	size_t count = widgets.count;
+	size_t i;
+	for (i = 0; i < widgets.count; i++) {
+		count += count_widgets(ui_widget_children(&widgets.items[i]));
+	}
+	return count;
+}
+
+bool save_interface_cache(
+	char const* path,
+	char* const* files,
+	size_t files_count,
+	struct sprite_list const* sprites,
+	struct ui_widget_list const* widgets,
+	struct bitmap_font_list const* bitmap_fonts,
+	struct font_list const* fonts
+) {
+	bool success = true;
+	struct cache_header header;
+	struct buffer buffer = {NULL, 0, 0, false};
+	struct string_table table = {NULL, 0, NULL, 0, false};
+	struct cache_file* cache_files = calloc(files_count + 1, sizeof(struct cache_file));
+	struct sprite* flat_sprites = malloc((sprites->count + 1) * sizeof(struct sprite));
+	size_t widgets_count = count_widgets(*widgets);
+	struct ui_widget* flat_widgets = malloc((widgets_count + 1) * sizeof(struct ui_widget));
+	struct bitmap_font* flat_bitmap_fonts = malloc((bitmap_fonts->count + 1) * sizeof(struct bitmap_font));
+	size_t color_codes_count = 0;
+	struct color_code* flat_color_codes = NULL;
+	struct font* flat_fonts = malloc((fonts->count + 1) * sizeof(struct font));
+	struct file_part part;
+	size_t i;
+
+	for (i = 0; i < bitmap_fonts->count; i++) {
+		color_codes_count += bitmap_fonts->items[i].color_codes.count;
+	}
+	flat_color_codes = malloc((color_codes_count + 1) * sizeof(struct color_code));
+
+	if (cache_files == NULL || flat_sprites == NULL || flat_widgets == NULL
+	    || flat_bitmap_fonts == NULL || flat_color_codes == NULL
+	    || flat_fonts == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the interface cache.\n");
+		success = false;
+		goto out;
+	}
+
+	for (i = 0; i < files_count; i++) {
+		if (!stamp_file(files[i], &cache_files[i].stamp)) {
+			fprintf(stderr, "Failed to read '%s': %s\n", files[i], strerror(errno));
+			success = false;
+			goto out;
+		}
+		cache_files[i].path = add_string(&table, files[i]);
+	}
+
+	for (i = 0; i < sprites->count; i++) {
+		flat_sprites[i] = sprites->items[i];
+		visit_sprite_strings(&flat_sprites[i], store_string, &table);
+	}
+
+	/* Children are appended behind the widgets queued so far. */
+	if (widgets->count > 0) {
+		memcpy(flat_widgets, widgets->items, widgets->count * sizeof(struct ui_widget));
+	}
+	{
+		size_t end = widgets->count;
+		for (i = 0; i < end; i++) {
+			struct ui_widget_list* children = children_of(&flat_widgets[i]);
+			if (children != NULL && children->count > 0) {
+				memcpy(flat_widgets + end, children->items,
+				       children->count * sizeof(struct ui_widget));
+				children->items = (struct ui_widget*) (uintptr_t) end;
+				end += children->count;
+			} else if (children != NULL) {
+				children->items = NULL;
+			}
+			visit_widget_strings(&flat_widgets[i], store_string, &table);
+		}
+	}
+
+	{
+		size_t end = 0;
+		for (i = 0; i < bitmap_fonts->count; i++) {
+			struct color_code_list* codes = &flat_bitmap_fonts[i].color_codes;
+			size_t j;
+			flat_bitmap_fonts[i] = bitmap_fonts->items[i];
+			for (j = 0; j < codes->count; j++) {
+				flat_color_codes[end + j] = codes->items[j];
+				store_string(&flat_color_codes[end + j].name, &table);
+			}
+			codes->items = (struct color_code*) (uintptr_t) end;
+			end += codes->count;
+			visit_bitmap_font_strings(&flat_bitmap_fonts[i], store_string, &table);
+		}
+	}
+
+	for (i = 0; i < fonts->count; i++) {
+		flat_fonts[i] = fonts->items[i];
+		visit_font_strings(&flat_fonts[i], store_string, &table);
+	}
+
+	if (table.failed) {
+		fprintf(stderr, "Failed to allocate memory for the interface cache.\n");
+		success = false;
+		goto out;
+	}
+
+	init_header(&header);
+	append(&buffer, &header, sizeof(struct cache_header));
+
+	header.files_count = files_count;
+	header.files_offset = align(&buffer);
+	append(&buffer, cache_files, files_count * sizeof(struct cache_file));
+
+	header.strings_count = table.count;
+	header.strings_offset = align(&buffer);
+	{
+		/* The text follows the table, so the offsets are known up front. */
+		uint64_t offset = header.strings_offset + table.count * sizeof(struct cache_string);
+		for (i = 0; i < table.count; i++) {
+			struct cache_string string;
+			string.offset = offset;
+			string.length = strlen(table.strings[i]);
+			append(&buffer, &string, sizeof(struct cache_string));
+			offset += string.length + 1;
+		}
+		for (i = 0; i < table.count; i++) {
+			append(&buffer, table.strings[i], strlen(table.strings[i]) + 1);
+		}
+	}
+
+	header.sprites_count = sprites->count;
+	header.sprites_offset = align(&buffer);
+	append(&buffer, flat_sprites, sprites->count * sizeof(struct sprite));
+
+	header.root_widgets_count = widgets->count;
+	header.widgets_count = widgets_count;
+	header.widgets_offset = align(&buffer);
+	append(&buffer, flat_widgets, widgets_count * sizeof(struct ui_widget));
+
+	header.bitmap_fonts_count = bitmap_fonts->count;
+	header.bitmap_fonts_offset = align(&buffer);
+	append(&buffer, flat_bitmap_fonts, bitmap_fonts->count * sizeof(struct bitmap_font));
+
+	header.color_codes_count = color_codes_count;
+	header.color_codes_offset = align(&buffer);
+	append(&buffer, flat_color_codes, color_codes_count * sizeof(struct color_code));
+
+	header.fonts_count = fonts->count;
+	header.fonts_offset = align(&buffer);
+	append(&buffer, flat_fonts, fonts->count * sizeof(struct font));
+
+	if (buffer.failed) {
+		fprintf(stderr, "Failed to allocate memory for the interface cache.\n");
+		success = false;
+		goto out;
+	}
+	memcpy(buffer.data, &header, sizeof(struct cache_header));
+
+	part.data = buffer.data;
+	part.size = buffer.size;
+	success = write_file_atomically(path, &part, 1);
+
+out:
+	free(buffer.data);
+	free(table.slots);
+	free(table.strings);
+	free(cache_files);
+	free(flat_sprites);
+	free(flat_widgets);
+	free(flat_bitmap_fonts);
+	free(flat_color_codes);
+	free(flat_fonts);
+	return success;
+}
+
+/* endregion */
+
+/* region load */
+
+struct relocation {
+	char const* data;
+	struct cache_string const* strings;
+	char const** interned;
+	size_t count;
+	bool valid;
+};
+
+/* Strings are interned the first time they are referenced. */
+static void load_string(char const** field, void* data) {
+	struct relocation* relocation = data;
+	uintptr_t index = (uintptr_t) *field;
+	if (index == 0) return;
+	if (index > relocation->count) {
+		relocation->valid = false;
+		*field = NULL;
+		return;
+	}
+	index -= 1;
+	if (relocation->interned[index] == NULL) {
+		relocation->interned[index] = intern_n(
+			relocation->data + relocation->strings[index].offset,
+			(size_t) relocation->strings[index].length
+		);
+	}
+	*field = relocation->interned[index];
+}
+
+static bool in_file(struct mapped_file const* file, uint64_t offset, uint64_t count, size_t size) {
+	return offset <= file->size && count <= (file->size - offset) / size;
+}
+
+static bool check_header(struct mapped_file const* file, struct cache_header const* header) {
+	struct cache_header expected;
+	init_header(&expected);
+	return header->magic == expected.magic
+	       && header->version == expected.version
+	       && header->pointer_size == expected.pointer_size
+	       && header->sprite_size == expected.sprite_size
+	       && header->widget_size == expected.widget_size
+	       && header->bitmap_font_size == expected.bitmap_font_size
+	       && header->color_code_size == expected.color_code_size
+	       && header->font_size == expected.font_size
+	       && header->root_widgets_count <= header->widgets_count
+	       && in_file(file, header->files_offset, header->files_count, sizeof(struct cache_file))
+	       && in_file(file, header->strings_offset, header->strings_count, sizeof(struct cache_string))
+	       && in_file(file, header->sprites_offset, header->sprites_count, sizeof(struct sprite))
+	       && in_file(file, header->widgets_offset, header->widgets_count, sizeof(struct ui_widget))
+	       && in_file(file, header->bitmap_fonts_offset, header->bitmap_fonts_count, sizeof(struct bitmap_font))
+	       && in_file(file, header->color_codes_offset, header->color_codes_count, sizeof(struct color_code))
+	       && in_file(file, header->fonts_offset, header->fonts_count, sizeof(struct font));
+}
+
+static bool check_strings(struct mapped_file const* file, struct cache_string const* strings, size_t count) {
+	size_t i;
+	for (i = 0; i < count; i++) {
+		if (!in_file(file, strings[i].offset, strings[i].length + 1, 1)
+		    || file->data[strings[i].offset + strings[i].length] != '\0') {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool check_files(struct mapped_file const* file, struct cache_header const* header,
+                        struct cache_string const* strings, char* const* files, size_t files_count) {
+	struct cache_file const* cache_files =
+		(struct cache_file const*) (file->data + header->files_offset);
+	size_t i;
+	if (header->files_count != files_count) return false;
+	for (i = 0; i < files_count; i++) {
+		if (cache_files[i].path >= header->strings_count
+		    || strcmp(file->data + strings[cache_files[i].path].offset, files[i]) != 0
+		    || !is_file_unchanged(files[i], &cache_files[i].stamp)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void* copy_table(struct arena* arena, struct mapped_file const* file,
+                        uint64_t offset, uint64_t count, size_t size) {
+	void* items;
+	if (count == 0) return NULL;
+	items = arena_alloc(arena, (size_t) count * size);
+	memcpy(items, file->data + offset, (size_t) count * size);
+	return items;
+}
+
+bool load_interface_cache(
+	char const* path,
+	char* const* files,
+	size_t files_count,
+	struct arena* arena,
+	struct sprite_list* sprites,
+	struct ui_widget_list* widgets,
+	struct bitmap_font_list* bitmap_fonts,
+	struct font_list* fonts
+) {
+	struct mapped_file file;
+	struct cache_header header;
+	struct relocation relocation;
+	struct sprite* new_sprites;
+	struct ui_widget* new_widgets;
+	struct bitmap_font* new_bitmap_fonts;
+	struct color_code* new_color_codes;
+	struct font* new_fonts;
+	size_t i;
+
+	if (!map_file(path, &file)) return false;
+	if (file.size < sizeof(struct cache_header)) {
+		unmap_file(&file);
+		return false;
+	}
+	memcpy(&header, file.data, sizeof(struct cache_header));
+	if (!check_header(&file, &header)) {
+		unmap_file(&file);
+		return false;
+	}
+	relocation.data = file.data;
+	relocation.strings = (struct cache_string const*) (file.data + header.strings_offset);
+	relocation.count = (size_t) header.strings_count;
+	relocation.valid = true;
+	if (!check_strings(&file, relocation.strings, relocation.count)
+	    || !check_files(&file, &header, relocation.strings, files, files_count)) {
+		unmap_file(&file);
+		return false;
+	}
+	if ((relocation.interned = calloc(relocation.count + 1, sizeof(char const*))) == NULL) {
+		unmap_file(&file);
+		return false;
+	}
+
+	new_sprites = copy_table(arena, &file, header.sprites_offset,
+	                         header.sprites_count, sizeof(struct sprite));
+	for (i = 0; i < header.sprites_count; i++) {
+		visit_sprite_strings(&new_sprites[i], load_string, &relocation);
+	}
+
+	new_widgets = copy_table(arena, &file, header.widgets_offset,
+	                         header.widgets_count, sizeof(struct ui_widget));
+	for (i = 0; i < header.widgets_count; i++) {
+		struct ui_widget_list* children = children_of(&new_widgets[i]);
+		if (children != NULL) {
+			uintptr_t first = (uintptr_t) children->items;
+			if (children->count == 0) {
+				children->items = NULL;
+			} else if (first < header.root_widgets_count
+			           || first > header.widgets_count
+			           || children->count > header.widgets_count - first) {
+				relocation.valid = false;
+				children->items = NULL;
+				children->count = 0;
+			} else {
+				children->items = new_widgets + first;
+			}
+		}
+		visit_widget_strings(&new_widgets[i], load_string, &relocation);
+	}
+
+	new_color_codes = copy_table(arena, &file, header.color_codes_offset,
+	                             header.color_codes_count, sizeof(struct color_code));
+	for (i = 0; i < header.color_codes_count; i++) {
+		load_string(&new_color_codes[i].name, &relocation);
+	}
+
+	new_bitmap_fonts = copy_table(arena, &file, header.bitmap_fonts_offset,
+	                              header.bitmap_fonts_count, sizeof(struct bitmap_font));
+	for (i = 0; i < header.bitmap_fonts_count; i++) {
+		struct color_code_list* codes = &new_bitmap_fonts[i].color_codes;
+		uintptr_t first = (uintptr_t) codes->items;
+		if (codes->count == 0) {
+			codes->items = NULL;
+		} else if (first > header.color_codes_count
+		           || codes->count > header.color_codes_count - first) {
+			relocation.valid = false;
+			codes->items = NULL;
+			codes->count = 0;
+		} else {
+			codes->items = new_color_codes + first;
+		}
+		visit_bitmap_font_strings(&new_bitmap_fonts[i], load_string, &relocation);
+	}
+
+	new_fonts = copy_table(arena, &file, header.fonts_offset,
+	                       header.fonts_count, sizeof(struct font));
+	for (i = 0; i < header.fonts_count; i++) {
+		visit_font_strings(&new_fonts[i], load_string, &relocation);
+	}
+
+	free(relocation.interned);
+	unmap_file(&file);
+	if (!relocation.valid) {
+		fprintf(stderr, "Ignoring corrupt interface cache '%s'.\n", path);
+		return false;
+	}
+
+	sprites->items = new_sprites;
+	sprites->count = (size_t) header.sprites_count;
+	widgets->items = new_widgets;
+	widgets->count = (size_t) header.root_widgets_count;
+	bitmap_fonts->items = new_bitmap_fonts;
+	bitmap_fonts->count = (size_t) header.bitmap_fonts_count;
+	fonts->items = new_fonts;
+	fonts->count = (size_t) header.fonts_count;
+	return true;
+}
+
+/* endregion */
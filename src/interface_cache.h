@@ -0,0 +1,39 @@
+#ifndef OV2_INTERFACE_CACHE_H
+#define OV2_INTERFACE_CACHE_H
+
+#include "parse.h"
+#include "arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Where the definitions parsed from interface/ are stored between runs. */
+#define INTERFACE_CACHE_PATH "ov2_interface.cache"
+
+/* Loads the definitions stored in `path` into `arena` and sets the lists to
+ * them. Returns false, leaving the lists untouched, if there is no cache or it
+ * was not written from exactly `files`, in that order and with their current
+ * contents. */
+bool load_interface_cache(
+	char const* path,
+	char* const* files,
+	size_t files_count,
+	struct arena* arena,
+	struct sprite_list* sprites,
+	struct ui_widget_list* widgets,
+	struct bitmap_font_list* bitmap_fonts,
+	struct font_list* fonts
+);
+
+/* Stores the definitions parsed from `files` in `path`. Must be called before
+ * anything modifies the parsed definitions, localization included. */
+bool save_interface_cache(
+	char const* path,
+	char* const* files,
+	size_t files_count,
+	struct sprite_list const* sprites,
+	struct ui_widget_list const* widgets,
+	struct bitmap_font_list const* bitmap_fonts,
+	struct font_list const* fonts
+);
+
+#endif /*OV2_INTERFACE_CACHE_H*/
@@ -0,0 +1,99 @@
+#include "intern.h"
+#include "arena.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+struct interned {
+	char const* str;
+	size_t len;
+	uint32_t hash;
+};
+
+/* Open addressing with linear probing, `capacity` is a power of two. Every
+ * parser thread interns its identifiers, so the strings are split among
+ * shards by the top bits of their hash, each with its own lock, table and
+ * storage: threads only wait on each other when they intern strings of the
+ * same shard at the same time, and a shard grows without stopping the
+ * others. */
+#define SHARD_BITS 6
+#define SHARDS_COUNT (1 << SHARD_BITS)
+
+struct shard {
+	SDL_SpinLock lock;
+	struct interned* table;
+	size_t capacity;
+	size_t count;
+	struct arena strings;
+	/* Keeps the locks of neighbouring shards off the same cache line. */
+	char padding[64];
+};
+
+static struct shard shards[SHARDS_COUNT];
+
+static uint32_t hash_string(char const* str, size_t len) {
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+	size_t i;
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char) str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void grow_table(struct shard* shard) {
+	size_t new_capacity = shard->capacity == 0 ? 256 : shard->capacity * 2;
+	struct interned* new_table = calloc(new_capacity, sizeof(struct interned));
+	size_t i;
+	if (new_table == NULL) {
+		fprintf(stderr, "Failed to allocate intern table: %s\n",
+		        strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < shard->capacity; i++) {
+		if (shard->table[i].str != NULL) {
+			size_t j = shard->table[i].hash & (new_capacity - 1);
+			while (new_table[j].str != NULL) {
+				j = (j + 1) & (new_capacity - 1);
+			}
+			new_table[j] = shard->table[i];
+		}
+	}
+	free(shard->table);
+	shard->table = new_table;
+	shard->capacity = new_capacity;
+}
+
+char const* intern_n(char const* str, size_t len) {
+	uint32_t hash = hash_string(str, len);
+	struct shard* shard = &shards[hash >> (32 - SHARD_BITS)];
+	char const* result;
+	size_t i;
+	SDL_AtomicLock(&shard->lock);
+	if ((shard->count + 1) * 2 > shard->capacity) grow_table(shard);
+	for (i = hash & (shard->capacity - 1);
+	     shard->table[i].str != NULL;
+	     i = (i + 1) & (shard->capacity - 1)) {
+		if (shard->table[i].hash == hash && shard->table[i].len == len
+		    && memcmp(shard->table[i].str, str, len) == 0) {
+			break;
+		}
+	}
+	if (shard->table[i].str == NULL) {
+		shard->table[i].str = arena_strndup(&shard->strings, str, len);
+		shard->table[i].len = len;
+		shard->table[i].hash = hash;
+		shard->count++;
+	}
+	result = shard->table[i].str;
+	SDL_AtomicUnlock(&shard->lock);
+	return result;
+}
+
+char const* intern(char const* str) {
+	return intern_n(str, strlen(str));
+}
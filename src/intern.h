@@ -0,0 +1,13 @@
+#ifndef OV2_INTERN_H
+#define OV2_INTERN_H
+
+#include <stddef.h>
+
+/* Returns the canonical, NUL-terminated copy of the first `len` bytes of `str`.
+ * Equal strings always get the same pointer, so interned strings can be
+ * compared with `==`. They stay valid until the program exits. */
+char const* intern_n(char const* str, size_t len);
+
+char const* intern(char const* str);
+
+#endif /*OV2_INTERN_H*/
@@ -0,0 +1,204 @@
+#include "lexer.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ctype.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void syntax_error(struct source* src, char* fmt, ...) {
+	va_list ap;
+
+	fprintf(stderr, "Syntax error in %s:%lu:%lu: ",
+		src->name, src->loc.lineno,src->loc.colno);
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+
+	fputc('\n', stderr);
+	exit(EXIT_FAILURE);
+}
+
+void syntax_warning(struct source* src, char* fmt, ...) {
+	va_list ap;
+
+	fprintf(stderr, "Warning in %s:%lu:%lu: ",
+		src->name, src->loc.lineno,src->loc.colno);
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+
+	fputc('\n', stderr);
+}
+
+void open_source(struct source* src, char const* path, struct arena* arena) {
+	if (!map_file(path, &src->file)) {
+		fprintf(stderr, "Failed to open file '%s': %s\n", path,
+		        strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	src->name = path;
+	src->cur = src->file.data;
+	src->end = src->file.data + src->file.size;
+	src->loc.lineno = 1;
+	src->loc.colno = 1;
+	src->arena = arena;
+}
+
+void close_source(struct source* src) {
+	unmap_file(&src->file);
+	src->cur = NULL;
+	src->end = NULL;
+}
+
+bool is_whitespace(char c) {
+	return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+bool is_identifier_char(char c) {
+	return isalnum((unsigned char) c) || c == '_';
+}
+
+/* Runs of whitespace and identifier characters are scanned a vector at a time
+ * where the target has SSE2 (always the case on x86-64) or AVX2, with a scalar
+ * loop for the tail and for other targets. Vectors are only loaded while they
+ * fit before `end`, the mapped file is not padded. */
+
+char const* skip_blanks(char const* cur, char const* end) {
+#if defined(__AVX2__)
+	while (end - cur >= 32) {
+		__m256i chunk = _mm256_loadu_si256((__m256i const*) cur);
+		__m256i blank = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+				_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+			_mm256_or_si256(
+				_mm256_or_si256(
+					_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')),
+					_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))),
+				_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(';'))));
+		uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(blank);
+		if (mask != 0) return cur + __builtin_ctz(mask);
+		cur += 32;
+	}
+#endif
+#if defined(__SSE2__)
+	while (end - cur >= 16) {
+		__m128i chunk = _mm_loadu_si128((__m128i const*) cur);
+		__m128i blank = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+			_mm_or_si128(
+				_mm_or_si128(
+					_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+					_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8(';'))));
+		unsigned mask = ~(unsigned) _mm_movemask_epi8(blank) & 0xffff;
+		if (mask != 0) return cur + __builtin_ctz(mask);
+		cur += 16;
+	}
+#endif
+	while (cur != end && (is_whitespace(*cur) || *cur == ';')) cur++;
+	return cur;
+}
+
+/* The compares are signed, which leaves bytes above 0x7f outside every range,
+ * as isalnum does in the C locale. */
+char const* skip_identifier(char const* cur, char const* end) {
+#if defined(__AVX2__)
+	while (end - cur >= 32) {
+		__m256i chunk = _mm256_loadu_si256((__m256i const*) cur);
+		__m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+		__m256i digit = _mm256_and_si256(
+			_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+		__m256i alpha = _mm256_and_si256(
+			_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+		__m256i word = _mm256_or_si256(
+			_mm256_or_si256(digit, alpha),
+			_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+		uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(word);
+		if (mask != 0) return cur + __builtin_ctz(mask);
+		cur += 32;
+	}
+#endif
+#if defined(__SSE2__)
+	while (end - cur >= 16) {
+		__m128i chunk = _mm_loadu_si128((__m128i const*) cur);
+		__m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+		__m128i digit = _mm_and_si128(
+			_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+			_mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chunk));
+		__m128i alpha = _mm_and_si128(
+			_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+			_mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), lower));
+		__m128i word = _mm_or_si128(
+			_mm_or_si128(digit, alpha),
+			_mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+		unsigned mask = ~(unsigned) _mm_movemask_epi8(word) & 0xffff;
+		if (mask != 0) return cur + __builtin_ctz(mask);
+		cur += 16;
+	}
+#endif
+	while (cur != end && is_identifier_char(*cur)) cur++;
+	return cur;
+}
+
+void advance_source(struct source* src, char const* to) {
+	char const* line = src->cur;
+	char const* newline;
+	while ((newline = memchr(line, '\n', (size_t) (to - line))) != NULL) {
+		src->loc.lineno += 1; /* TODO overflow */
+		line = newline + 1;
+	}
+	if (line == src->cur) {
+		src->loc.colno += (uint64_t) (to - line); /* TODO overflow */
+	} else {
+		src->loc.colno = (uint64_t) (to - line);
+	}
+	src->cur = to;
+}
+
+void consume_whitespace_and_comments(struct source* src) {
+	char const* cur = src->cur;
+	for (;;) {
+		cur = skip_blanks(cur, src->end);
+		if (cur == src->end || *cur != '#') break;
+		/* Comments run up to and including the end of the line. */
+		cur = memchr(cur, '\n', (size_t) (src->end - cur));
+		cur = cur == NULL ? src->end : cur + 1;
+	}
+	advance_source(src, cur);
+}
+
+bool peek_char(struct source* src, char* c, bool ignore_whitespace) {
+	if (ignore_whitespace) consume_whitespace_and_comments(src);
+
+	if (src->cur == src->end) return false;
+	*c = *src->cur;
+	return true;
+}
+
+bool consume_char(struct source* src, char* c, bool ignore_whitespace) {
+	if (ignore_whitespace) consume_whitespace_and_comments(src);
+
+	if (src->cur == src->end) return false;
+	*c = *src->cur++;
+
+	if (*c == '\n') {
+		src->loc.lineno += 1; /* TODO overflow */
+		src->loc.colno = 0;
+	} else {
+		src->loc.colno += 1; /* TODO overflow */
+	}
+	return true;
+}
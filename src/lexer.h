@@ -0,0 +1,55 @@
+#ifndef OV2_LEXER_H
+#define OV2_LEXER_H
+
+#include "fs.h"
+#include "arena.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Byte-level scanning shared by the interface parser and the script reader. */
+
+struct loc {
+	uint64_t lineno;
+	uint64_t colno;
+};
+
+struct source {
+	char const* name;
+	struct mapped_file file;
+	char const* cur;
+	char const* end;
+	struct loc loc;
+	/* Where parsed definitions are allocated, NULL if nothing is. */
+	struct arena* arena;
+};
+
+/* Maps the whole file at `path`, the source is a cursor over its bytes. Exits
+ * the program if the file can not be opened. */
+void open_source(struct source* src, char const* path, struct arena* arena);
+void close_source(struct source* src);
+
+/* Print the message with the current location, syntax_error then exits. */
+void syntax_error(struct source* src, char* fmt, ...);
+void syntax_warning(struct source* src, char* fmt, ...);
+
+bool is_whitespace(char c);
+/* [0-9A-Za-z_] */
+bool is_identifier_char(char c);
+
+/* Return the first byte in [cur, end) that is not whitespace or ';', or not an
+ * identifier character. */
+char const* skip_blanks(char const* cur, char const* end);
+char const* skip_identifier(char const* cur, char const* end);
+
+/* Moves the cursor forward to `to`, updating the location exactly as
+ * consuming the bytes one at a time would. */
+void advance_source(struct source* src, char const* to);
+
+/* Skips whitespace, ';' and '#' comments up to the end of their line. */
+void consume_whitespace_and_comments(struct source* src);
+
+/* Return false if EOF */
+bool peek_char(struct source* src, char* c, bool ignore_whitespace);
+bool consume_char(struct source* src, char* c, bool ignore_whitespace);
+
+#endif /*OV2_LEXER_H*/
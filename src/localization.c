@@ -1,6 +1,9 @@
 #include "localization.h"
 #include "csv.h"
 #include "fs.h"
+#include "intern.h"
+#include "workers.h"
+#include "vfs.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -8,191 +11,636 @@
 #include <stdlib.h>
 #include <assert.h>
 
-static void load_localizations_from_file(
-	char const* path,
-	struct localization** locs,
-	size_t* count
-) {
-	struct csv_file* csv = csv_open(path);
+/* The localizations of one file, read on a worker thread. `keys` and `texts`
+ * hold the strings the offsets in `locs` are relative to. */
+struct localization_job {
+	char const* path;
+	enum language language;
+	struct localization* locs;
+	size_t count;
+	char* keys;
+	size_t keys_size;
+	char* texts;
+	size_t texts_size;
+	struct text_segment* segments;
+	size_t segments_count;
+	bool failed;
+};
+
+static uint32_t append_field(char* pool, size_t* size, struct csv_field const* field) {
+	uint32_t offset = (uint32_t) *size;
+	memcpy(pool + *size, field->data, field->length);
+	pool[*size + field->length] = '\0';
+	*size += field->length + 1;
+	return offset;
+}
+
+static bool allocate_pool(struct localization_job* job, char** pool, size_t size) {
+	if ((*pool = malloc(size)) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for '%s': %s\n",
+		        job->path, strerror(errno));
+		job->failed = true;
+		return false;
+	}
+	return true;
+}
+
+/* Splits the texts of the job into segments, with offsets into its pool. */
+static void compile_job_templates(struct localization_job* job) {
+	size_t count = 0;
+	size_t i, j;
+	for (i = 0; i < job->count; i++) {
+		count += compile_text_template(job->texts + job->locs[i].text, NULL);
+	}
+	if (count != 0
+	    && (job->segments = malloc(count * sizeof(struct text_segment))) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for '%s': %s\n",
+		        job->path, strerror(errno));
+		job->failed = true;
+		return;
+	}
+	for (i = 0; i < job->count; i++) {
+		struct localization* loc = &job->locs[i];
+		struct text_segment* segments = job->segments + job->segments_count;
+		size_t n = compile_text_template(job->texts + loc->text, segments);
+		for (j = 0; j < n; j++) segments[j].offset += loc->text;
+		loc->first_segment = (uint32_t) job->segments_count;
+		job->segments_count += n;
+	}
+}
+
+/* Reads the keys of a file, and the texts in the job's language. */
+static void load_localization_file(void* data, size_t index) {
+	struct localization_job* job = (struct localization_job*) data + index;
+	size_t const column = (size_t) job->language + 1;
+	struct csv_file* csv = csv_open(job->path);
+	struct csv_field field;
+	size_t first, row;
+	size_t keys_size = 0, texts_size = 0;
 	if (csv == NULL) {
 		fprintf(stderr, "Failed to open '%s': %s\n",
-		        path, strerror(errno));
+		        job->path, strerror(errno));
+		return;
+	}
+	/* The first line is not read, as a header. */
+	first = csv->row_count != 0 && csv->line_numbers[0] == 1 ? 1 : 0;
+	if (first == csv->row_count) {
+		csv_close(csv);
+		return;
+	}
+	/* Languages missing from the end of a line are empty. */
+	for (row = first; row < csv->row_count; row++) {
+		csv_get_field(csv, row, 0, &field);
+		keys_size += field.length + 1;
+		csv_get_field(csv, row, column, &field);
+		texts_size += field.length + 1;
+	}
+	job->locs = malloc((csv->row_count - first) * sizeof(struct localization));
+	if (job->locs == NULL) {
+		fprintf(stderr, "Failed to allocate memory for "
+		                "localizations: %s\n",
+		        strerror(errno));
+		job->failed = true;
+	} else if (allocate_pool(job, &job->keys, keys_size)
+	           && allocate_pool(job, &job->texts, texts_size)) {
+		for (row = first; row < csv->row_count; row++) {
+			struct localization* loc = &job->locs[job->count++];
+			csv_get_field(csv, row, 0, &field);
+			loc->key = append_field(job->keys, &job->keys_size, &field);
+			csv_get_field(csv, row, column, &field);
+			loc->text = append_field(job->texts, &job->texts_size, &field);
+			loc->row = (uint32_t) row;
+		}
+		compile_job_templates(job);
+	}
+	csv_close(csv);
+}
+
+/* Reads the texts of localizations already in `job->locs` in the job's
+ * language, from the rows they were first read from. */
+static void reload_localization_file(void* data, size_t index) {
+	struct localization_job* job = (struct localization_job*) data + index;
+	size_t const column = (size_t) job->language + 1;
+	struct csv_file* csv;
+	struct csv_field field;
+	size_t texts_size = 0;
+	size_t i;
+	if (job->count == 0) return;
+	if ((csv = csv_open(job->path)) == NULL) {
+		fprintf(stderr, "Failed to open '%s': %s\n",
+		        job->path, strerror(errno));
+		job->failed = true;
 		return;
 	}
-	if (!csv_read_line(csv)) {
-		fprintf(stderr, "Failed to read first line of '%s': %s\n",
-		        path, strerror(errno));
-	} else {
-		bool success = true;
-		while (csv_read_line(csv)) {
-			struct localization* loc = NULL;
-			struct localization* new_locs = reallocarray(
-				*locs, *count + 1, sizeof(struct localization)
+	for (i = 0; i < job->count; i++) {
+		if (job->locs[i].row >= csv->row_count) {
+			fprintf(stderr, "'%s' has changed since it was loaded.\n",
+			        job->path);
+			job->failed = true;
+			csv_close(csv);
+			return;
+		}
+		csv_get_field(csv, job->locs[i].row, column, &field);
+		texts_size += field.length + 1;
+	}
+	if (allocate_pool(job, &job->texts, texts_size)) {
+		for (i = 0; i < job->count; i++) {
+			csv_get_field(csv, job->locs[i].row, column, &field);
+			job->locs[i].text = append_field(job->texts, &job->texts_size, &field);
+		}
+		compile_job_templates(job);
+	}
+	csv_close(csv);
+}
+
+/* Copies the texts and segments of every job into one pool each, moving the
+ * offsets in the jobs' lists along with them. */
+static bool concatenate_texts(struct localization_job* jobs, size_t count,
+                              char** texts, struct text_segment** segments,
+                              size_t* segments_count) {
+	size_t size = 0;
+	size_t segments_size = 0;
+	size_t i, j;
+	for (i = 0; i < count; i++) {
+		size += jobs[i].texts_size;
+		segments_size += jobs[i].segments_count;
+	}
+	if (size >= UINT32_MAX || segments_size >= UINT32_MAX) {
+		fprintf(stderr, "Too much localization text.\n");
+		return false;
+	}
+	*texts = malloc(size == 0 ? 1 : size);
+	*segments = malloc(segments_size == 0 ? 1 : segments_size * sizeof(struct text_segment));
+	if (*texts == NULL || *segments == NULL) {
+		fprintf(stderr, "Failed to allocate memory for "
+		                "localizations: %s\n",
+		        strerror(errno));
+		free(*texts);
+		free(*segments);
+		*texts = NULL;
+		*segments = NULL;
+		return false;
+	}
+	size = 0;
+	segments_size = 0;
+	for (i = 0; i < count; i++) {
+		struct localization_job* job = &jobs[i];
+		if (job->texts_size != 0) {
+			memcpy(*texts + size, job->texts, job->texts_size);
+		}
+		for (j = 0; j < job->count; j++) {
+			job->locs[j].text += (uint32_t) size;
+			job->locs[j].first_segment += (uint32_t) segments_size;
+		}
+		for (j = 0; j < job->segments_count; j++) {
+			struct text_segment* segment = &(*segments)[segments_size + j];
+			*segment = job->segments[j];
+			segment->offset += (uint32_t) size;
+		}
+		size += job->texts_size;
+		segments_size += job->segments_count;
+	}
+	*segments_count = segments_size;
+	return true;
+}
+
+static uint32_t hash_key(char const* key) {
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+	for (; *key != '\0'; key++) {
+		hash ^= (unsigned char) *key;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/* Indexes the keys in order, a later definition of a key taking the slot of
+ * an earlier one. The table is kept at most half full. */
+static bool build_index(struct localization_table* table) {
+	size_t capacity = 16;
+	size_t i;
+	if (table->count >= UINT32_MAX) {
+		fprintf(stderr, "Too many localizations.\n");
+		return false;
+	}
+	while (capacity < table->count * 2) capacity *= 2;
+	table->index = calloc(capacity, sizeof(struct localization_slot));
+	if (table->index == NULL) {
+		fprintf(stderr, "Failed to allocate memory for "
+		                "localization index: %s\n",
+		        strerror(errno));
+		return false;
+	}
+	table->index_capacity = capacity;
+	for (i = 0; i < table->count; i++) {
+		char const* key = table->keys + table->items[i].key;
+		uint32_t hash = hash_key(key);
+		size_t j = hash & (capacity - 1);
+		while (table->index[j].item != 0
+		       && (table->index[j].hash != hash
+		           || strcmp(table->keys + table->items[table->index[j].item - 1].key, key) != 0)) {
+			j = (j + 1) & (capacity - 1);
+		}
+		table->index[j].hash = hash;
+		table->index[j].item = (uint32_t) i + 1;
+	}
+	return true;
+}
+
+/* Lists the files in localisation/ in name order. */
+static bool list_sources(struct localization_table* table) {
+	size_t capacity = 0;
+	struct asset const* asset;
+	bool success = true;
+	if ((asset = list_assets("localisation")) == NULL) {
+		fprintf(stderr, "No localization files found\n");
+		return false;
+	}
+	for (; asset != NULL; asset = asset->next) {
+		struct localization_source* source;
+		if (asset->is_directory) continue;
+		if (table->sources_count == capacity) {
+			size_t new_capacity = capacity == 0 ? 64 : capacity * 2;
+			struct localization_source* new_sources = realloc(
+				table->sources,
+				new_capacity * sizeof(struct localization_source)
 			);
-			if (new_locs == NULL) {
+			if (new_sources == NULL) {
 				fprintf(stderr, "Failed to allocate memory for "
-				                "province definitions: %s\n",
-				        strerror(errno));
-				success = false;
-				break;
-			}
-			*locs = new_locs;
-			(*count)++;
-			loc = &(*locs)[*count - 1];
-			if (
-				!csv_read_string(csv, &loc->key)
-				|| !csv_read_string(csv, &loc->english)
-				|| !csv_read_string(csv, &loc->french)
-				|| !csv_read_string(csv, &loc->german)
-				|| !csv_read_string(csv, &loc->polish)
-				|| !csv_read_string(csv, &loc->spanish)
-				|| !csv_read_string(csv, &loc->italian)
-				|| !csv_read_string(csv, &loc->swedish)
-				|| !csv_read_string(csv, &loc->czech)
-				|| !csv_read_string(csv, &loc->hungarian)
-				|| !csv_read_string(csv, &loc->dutch)
-				|| !csv_read_string(csv, &loc->portuguese)
-				|| !csv_read_string(csv, &loc->russian)
-				|| !csv_read_string(csv, &loc->finnish)
-			) {
-				fprintf(stderr, "Failed to read '%s'.", path);
+				                "localization files.\n");
 				success = false;
 				break;
 			}
+			table->sources = new_sources;
+			capacity = new_capacity;
+		}
+		source = &table->sources[table->sources_count];
+		if ((source->path = malloc(strlen(asset->path) + 1)) == NULL) {
+			fprintf(stderr, "Failed to allocate memory for path.\n");
+			success = false;
+			break;
 		}
+		strcpy(source->path, asset->path);
+		source->first = 0;
+		source->count = 0;
+		table->sources_count++;
+	}
+	return success;
+}
+
+static void free_jobs(struct localization_job* jobs, size_t count) {
+	size_t i;
+	if (jobs == NULL) return;
+	for (i = 0; i < count; i++) {
+		free(jobs[i].locs);
+		free(jobs[i].keys);
+		free(jobs[i].texts);
+		free(jobs[i].segments);
+	}
+	free(jobs);
+}
+
+void load_localizations(struct localization_table* table, enum language language) {
+	struct localization_job* jobs = NULL;
+	size_t keys_size = 0;
+	bool success;
+	size_t i, j;
+	memset(table, 0, sizeof(struct localization_table));
+	table->language = language;
+
+	if ((success = list_sources(table))
+	    && (jobs = calloc(table->sources_count + 1,
+	                      sizeof(struct localization_job))) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for "
+		                "localization files.\n");
+		success = false;
+	}
+	/* The files are read in parallel but concatenated in name order, where
+	 * a later definition of a key overrides an earlier one as in the game,
+	 * whatever order the directory lists them in. */
+	if (success) {
+		for (i = 0; i < table->sources_count; i++) {
+			jobs[i].path = table->sources[i].path;
+			jobs[i].language = language;
+		}
+		parallel_for(table->sources_count, load_localization_file, jobs);
+		for (i = 0; i < table->sources_count; i++) {
+			success &= !jobs[i].failed;
+			keys_size += jobs[i].keys_size;
+			table->sources[i].first = table->count;
+			table->sources[i].count = jobs[i].count;
+			table->count += jobs[i].count;
+		}
+	}
+	if (success && table->count != 0) {
+		success = keys_size < UINT32_MAX
+		          && (table->items = malloc(table->count * sizeof(struct localization))) != NULL
+		          && (table->keys = malloc(keys_size)) != NULL
+		          && concatenate_texts(jobs, table->sources_count, &table->texts,
+		                               &table->segments, &table->segments_count);
 		if (!success) {
-			if (*locs != NULL) {
-				free_localizations(*locs, *count);
-				*locs = NULL;
+			fprintf(stderr, "Failed to allocate memory for "
+			                "localizations.\n");
+		}
+	}
+	if (success && table->count != 0) {
+		keys_size = 0;
+		for (i = 0; i < table->sources_count; i++) {
+			struct localization_job* job = &jobs[i];
+			struct localization* items = table->items + table->sources[i].first;
+			memcpy(table->keys + keys_size, job->keys, job->keys_size);
+			for (j = 0; j < job->count; j++) {
+				items[j] = job->locs[j];
+				items[j].key += (uint32_t) keys_size;
 			}
-			*count = 0;
+			keys_size += job->keys_size;
 		}
+		success = build_index(table);
 	}
-	csv_close(csv);
+	free_jobs(jobs, table->sources_count);
+	if (!success || table->count == 0) {
+		free_localizations(table);
+		table->language = language;
+	}
+}
+
+bool set_localization_language(struct localization_table* table, enum language language) {
+	struct localization_job* jobs;
+	char* texts = NULL;
+	struct text_segment* segments = NULL;
+	size_t segments_count = 0;
+	bool success = true;
+	size_t i;
+	if (language == table->language) return true;
+	if ((jobs = calloc(table->sources_count + 1, sizeof(struct localization_job))) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for "
+		                "localization files.\n");
+		return false;
+	}
+	/* Every job works on a copy of its part of the list, so that a failure
+	 * leaves the table as it was. */
+	for (i = 0; i < table->sources_count && success; i++) {
+		struct localization_source const* source = &table->sources[i];
+		jobs[i].path = source->path;
+		jobs[i].language = language;
+		jobs[i].count = source->count;
+		if (source->count == 0) continue;
+		jobs[i].locs = malloc(source->count * sizeof(struct localization));
+		if (jobs[i].locs == NULL) {
+			fprintf(stderr, "Failed to allocate memory for "
+			                "localizations: %s\n",
+			        strerror(errno));
+			success = false;
+		} else {
+			memcpy(jobs[i].locs, table->items + source->first,
+			       source->count * sizeof(struct localization));
+		}
+	}
+	if (success) {
+		parallel_for(table->sources_count, reload_localization_file, jobs);
+		for (i = 0; i < table->sources_count; i++) {
+			success &= !jobs[i].failed;
+		}
+	}
+	if (success && !concatenate_texts(jobs, table->sources_count, &texts,
+	                                  &segments, &segments_count)) {
+		success = false;
+	}
+	if (success) {
+		for (i = 0; i < table->sources_count; i++) {
+			if (jobs[i].count == 0) continue;
+			memcpy(table->items + table->sources[i].first, jobs[i].locs,
+			       jobs[i].count * sizeof(struct localization));
+		}
+		free(table->texts);
+		free(table->segments);
+		table->texts = texts;
+		table->segments = segments;
+		table->segments_count = segments_count;
+		table->language = language;
+	}
+	free_jobs(jobs, table->sources_count);
+	return success;
+}
+
+void free_localizations(struct localization_table* table) {
+	size_t i;
+	for (i = 0; i < table->sources_count; i++) {
+		free(table->sources[i].path);
+	}
+	free(table->sources);
+	free(table->items);
+	free(table->keys);
+	free(table->texts);
+	free(table->segments);
+	free(table->index);
+	memset(table, 0, sizeof(struct localization_table));
 }
 
-void load_localizations(
-	struct localization** localizations,
-	size_t* count
+char const* localization_key(
+	struct localization_table const* table,
+	struct localization const* localization
 ) {
-	*localizations = NULL;
-	*count = 0;
+	return table->keys + localization->key;
+}
 
-	DIR* dir;
-	struct dirent* entry;
-	if ((dir = opendir("localisation")) == NULL) {
-		fprintf(stderr, "Failed to open localization directory\n");
-		return;
+char const* localization_text(
+	struct localization_table const* table,
+	struct localization const* localization
+) {
+	return table->texts + localization->text;
+}
+
+void localization_template(
+	struct localization_table const* table,
+	struct localization const* localization,
+	struct text_template* template
+) {
+	size_t end = localization + 1 != table->items + table->count
+	             ? localization[1].first_segment : table->segments_count;
+	template->text = table->texts;
+	template->segments = table->segments + localization->first_segment;
+	template->count = end - localization->first_segment;
+}
+
+static bool is_parameter_char(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+	       || (c >= '0' && c <= '9') || c == '_';
+}
+
+static void add_segment(struct text_segment* segments, size_t* count,
+                        enum text_segment_type type,
+                        char const* text, char const* start, size_t length) {
+	if (segments != NULL) {
+		segments[*count].offset = (uint32_t) (start - text);
+		segments[*count].length = (uint32_t) length;
+		segments[*count].type = type;
 	}
-	while ((entry = readdir(dir)) != NULL) {
-		if (entry->d_type != DT_REG) continue;
-		char* path = malloc(strlen("localisation/")
-		             + strlen(entry->d_name) + 1);
-		if (path == NULL) {
-			fprintf(stderr, "Failed to allocate memory for path.\n");
-			break;
+	*count += 1;
+}
+
+/* A '$' only starts a parameter when a name and another '$' follow, and a
+ * color code marker at the very end is kept as it is. */
+size_t compile_text_template(char const* text, struct text_segment* segments) {
+	char const* literal = text;
+	char const* cur = text;
+	size_t count = 0;
+	while (*cur != '\0') {
+		char const* end = cur + 1;
+		enum text_segment_type type;
+		if (*cur == '$') {
+			while (is_parameter_char(*end)) end++;
+			if (end == cur + 1 || *end != '$') {
+				cur = end;
+				continue;
+			}
+			type = TEXT_SEGMENT_PARAMETER;
+		} else if (*cur == COLOR_CODE_MARKER && *end != '\0') {
+			end++;
+			type = TEXT_SEGMENT_COLOR;
+		} else {
+			cur++;
+			continue;
 		}
-		strcpy(path, "localisation/");
-		strcat(path, entry->d_name);
-		load_localizations_from_file(path, localizations, count);
-		free(path);
+		if (literal != cur) {
+			add_segment(segments, &count, TEXT_SEGMENT_LITERAL, text,
+			            literal, (size_t) (cur - literal));
+		}
+		add_segment(segments, &count, type, text, cur + 1,
+		            type == TEXT_SEGMENT_COLOR ? 1 : (size_t) (end - cur - 1));
+		cur = literal = type == TEXT_SEGMENT_COLOR ? end : end + 1;
+	}
+	if (literal != cur) {
+		add_segment(segments, &count, TEXT_SEGMENT_LITERAL, text,
+		            literal, (size_t) (cur - literal));
 	}
-	closedir(dir);
+	return count;
 }
 
-void free_localizations(
-	struct localization* locs,
-	size_t count
+size_t format_text(
+	struct text_template const* template,
+	struct text_parameter const* parameters,
+	size_t parameters_count,
+	char* buffer,
+	size_t size
 ) {
+	size_t length = 0;
+	size_t i, j;
+	if (size == 0) return 0;
+	for (i = 0; i < template->count; i++) {
+		struct text_segment const* segment = &template->segments[i];
+		char const* text = template->text + segment->offset;
+		size_t text_length = segment->length;
+		if (segment->type == TEXT_SEGMENT_PARAMETER) {
+			char const* name = text;
+			/* With the '$'s around it. */
+			text -= 1;
+			text_length += 2;
+			for (j = 0; j < parameters_count; j++) {
+				if (strncmp(parameters[j].name, name, segment->length) == 0
+				    && parameters[j].name[segment->length] == '\0') {
+					text = parameters[j].value;
+					text_length = strlen(text);
+					break;
+				}
+			}
+		} else if (segment->type == TEXT_SEGMENT_COLOR) {
+			/* With the marker before it. */
+			text -= 1;
+			text_length += 1;
+		}
+		if (text_length > size - 1 - length) text_length = size - 1 - length;
+		memcpy(buffer + length, text, text_length);
+		length += text_length;
+	}
+	buffer[length] = '\0';
+	return length;
+}
+
+struct localization const* localization_lookup(
+	struct localization_table const* table,
+	char const* key
+) {
+	uint32_t hash;
 	size_t i;
-	for (i = 0; i < count; i++) {
-		if(locs[i].key != NULL) free(locs[i].key);
-		if(locs[i].english != NULL) free(locs[i].english);
-		if(locs[i].french != NULL) free(locs[i].french);
-		if(locs[i].german != NULL) free(locs[i].german);
-		if(locs[i].polish != NULL) free(locs[i].polish);
-		if(locs[i].spanish != NULL) free(locs[i].spanish);
-		if(locs[i].italian != NULL) free(locs[i].italian);
-		if(locs[i].swedish != NULL) free(locs[i].swedish);
-		if(locs[i].czech != NULL) free(locs[i].czech);
-		if(locs[i].hungarian != NULL) free(locs[i].hungarian);
-		if(locs[i].dutch != NULL) free(locs[i].dutch);
-		if(locs[i].portuguese != NULL) free(locs[i].portuguese);
-		if(locs[i].russian != NULL) free(locs[i].russian);
-		if(locs[i].finnish != NULL) free(locs[i].finnish);
-	}
-	free(locs);
-}
-
-/* This returns a caller-owned string, and will free any existing `text` string
- * if a localization is found. */
-static char* localize_text(char* text, struct localization* locs, size_t count) {
-	size_t i;
-	if(text == NULL) return NULL;
-	for (i = 0; i < count; i++) {
-		if (strcmp(locs[i].key, text) == 0) {
-			if(text != NULL) free(text);
-			return strdup(locs[i].english);
+	if (table->index_capacity == 0) return NULL;
+	hash = hash_key(key);
+	for (i = hash & (table->index_capacity - 1);
+	     table->index[i].item != 0;
+	     i = (i + 1) & (table->index_capacity - 1)) {
+		struct localization const* loc = &table->items[table->index[i].item - 1];
+		if (table->index[i].hash == hash
+		    && strcmp(table->keys + loc->key, key) == 0) {
+			return loc;
 		}
 	}
-	return text;
+	return NULL;
+}
+
+/* Returns the interned localization of `text`, or `text` itself if there is
+ * none. */
+static char const* localize_text(char const* text, struct localization_table const* table) {
+	struct localization const* loc;
+	if (text == NULL) return NULL;
+	loc = localization_lookup(table, text);
+	return loc != NULL ? intern(localization_text(table, loc)) : text;
 }
 
 void localize_ui_widgets(
-	struct ui_widget* widgets,
-	struct localization* locs,
-	size_t locs_count
+	struct ui_widget_list widgets,
+	struct localization_table const* table
 ) {
 	/* TODO: Tooltips. */
 	size_t i;
-	for (; widgets != NULL; widgets = widgets->next) {
-		switch (widgets->type) {
+	for (i = 0; i < widgets.count; i++) {
+		struct ui_widget* widget = &widgets.items[i];
+		switch (widget->type) {
 		case TYPE_WINDOW:
 			localize_ui_widgets(
-				widgets->window.children,
-				locs, locs_count
+				widget->window.children,
+				table
 			);
 			break;
 		case TYPE_BUTTON:
-			widgets->button.button_text = localize_text(
-				widgets->button.button_text,
-				locs, locs_count
+			widget->button.button_text = localize_text(
+				widget->button.button_text,
+				table
 			);
 			break;
 		case TYPE_TEXT_BOX:
-			widgets->text_box.text = localize_text(
-				widgets->text_box.text,
-				locs, locs_count
+			widget->text_box.text = localize_text(
+				widget->text_box.text,
+				table
 			);
 			break;
 		case TYPE_INSTANT_TEXT_BOX:
-			widgets->instant_text_box.text = localize_text(
-				widgets->instant_text_box.text,
-				locs, locs_count
+			widget->instant_text_box.text = localize_text(
+				widget->instant_text_box.text,
+				table
 			);
 			break;
 		case TYPE_SCROLLBAR:
 			localize_ui_widgets(
-				widgets->scrollbar.children,
-				locs, locs_count
+				widget->scrollbar.children,
+				table
 			);
 			break;
 		case TYPE_CHECKBOX:
-			widgets->checkbox.button_text = localize_text(
-				widgets->checkbox.button_text,
-				locs, locs_count
+			widget->checkbox.button_text = localize_text(
+				widget->checkbox.button_text,
+				table
 			);
 			break;
 		case TYPE_EDIT_BOX:
-			widgets->edit_box.text = localize_text(
-				widgets->edit_box.text,
-				locs, locs_count
+			widget->edit_box.text = localize_text(
+				widget->edit_box.text,
+				table
 			);
 			break;
 		case TYPE_EU3_DIALOG:
 			localize_ui_widgets(
-				widgets->eu3_dialog.children,
-				locs, locs_count
+				widget->eu3_dialog.children,
+				table
 			);
 			break;
 		case TYPE_ICON:
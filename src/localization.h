@@ -6,38 +6,148 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/* The languages of a localisation file, in the order of their columns after
+ * the key. */
+enum language {
+	LANGUAGE_ENGLISH,
+	LANGUAGE_FRENCH,
+	LANGUAGE_GERMAN,
+	LANGUAGE_POLISH,
+	LANGUAGE_SPANISH,
+	LANGUAGE_ITALIAN,
+	LANGUAGE_SWEDISH,
+	LANGUAGE_CZECH,
+	LANGUAGE_HUNGARIAN,
+	LANGUAGE_DUTCH,
+	LANGUAGE_PORTUGUESE,
+	LANGUAGE_RUSSIAN,
+	LANGUAGE_FINNISH,
+	LANGUAGE_COUNT
+};
+
 struct localization {
-	char* key;
-    	char* english;
-	char* french;
-	char* german;
-	char* polish;
-	char* spanish;
-	char* italian;
-	char* swedish;
-	char* czech;
-	char* hungarian;
-	char* dutch;
-	char* portuguese;
-	char* russian;
-	char* finnish;
-};
-
-/* Returns an empty list on failure */
-void load_localizations(
-	struct localization** localizations,
-	size_t* count
+	/* Offsets of NUL-terminated strings in the table's `keys` and `texts`. */
+	uint32_t key;
+	uint32_t text;
+	/* The row of the localization in its file, where the text in another
+	 * language is read from. */
+	uint32_t row;
+	/* The first of the segments of the text in the table's `segments`, which
+	 * run up to the first segment of the next localization. */
+	uint32_t first_segment;
+};
+
+/* The localizations read from one file, which follow each other in the
+ * table. */
+struct localization_source {
+	char* path;
+	size_t first;
+	size_t count;
+};
+
+enum text_segment_type {
+	TEXT_SEGMENT_LITERAL,
+	/* A `$NAME$` placeholder, `offset` and `length` select the name. */
+	TEXT_SEGMENT_PARAMETER,
+	/* A color code, `offset` selects the character after the marker. */
+	TEXT_SEGMENT_COLOR
+};
+
+struct text_segment {
+	uint32_t offset;
+	uint32_t length;
+	enum text_segment_type type;
+};
+
+/* A text split into segments once, so that it can be formatted repeatedly.
+ * Segment offsets are relative to `text`. */
+struct text_template {
+	char const* text;
+	struct text_segment const* segments;
+	size_t count;
+};
+
+struct text_parameter {
+	char const* name;
+	char const* value;
+};
+
+struct localization_slot {
+	uint32_t hash;
+	/* Index of the localization plus one, 0 for an empty slot. */
+	uint32_t item;
+};
+
+/* Every localization, with an index from key to the definition that counts.
+ * Only the text in `language` is kept in memory. The index uses open
+ * addressing with linear probing, `index_capacity` is a power of two. */
+struct localization_table {
+	enum language language;
+	struct localization* items;
+	size_t count;
+	char* keys;
+	char* texts;
+	struct text_segment* segments;
+	size_t segments_count;
+	struct localization_source* sources;
+	size_t sources_count;
+	struct localization_slot* index;
+	size_t index_capacity;
+};
+
+/* Loads every file in localisation/, in name order; where a key is defined
+ * more than once the last definition wins. Returns an empty table on failure,
+ * to be freed with free_localizations either way. */
+void load_localizations(struct localization_table* table, enum language language);
+
+/* Reads the text of every localization in `language` from the files again.
+ * Returns false, keeping the current language, on failure. */
+bool set_localization_language(struct localization_table* table, enum language language);
+
+void free_localizations(struct localization_table* table);
+
+char const* localization_key(
+	struct localization_table const* table,
+	struct localization const* localization
+);
+
+char const* localization_text(
+	struct localization_table const* table,
+	struct localization const* localization
+);
+
+/* Gets the text of `localization` as a template, split when it was loaded. */
+void localization_template(
+	struct localization_table const* table,
+	struct localization const* localization,
+	struct text_template* template
+);
+
+/* Splits `text` into `segments` and returns how many there are; with
+ * `segments` NULL they are only counted. */
+size_t compile_text_template(char const* text, struct text_segment* segments);
+
+/* Writes the text to `buffer`, which holds `size` bytes, with every parameter
+ * replaced by its value and truncated to fit. Parameters without a value are
+ * written as they are, as are color codes, for the font to color the text.
+ * Returns the length of what was written. Nothing is allocated. */
+size_t format_text(
+	struct text_template const* template,
+	struct text_parameter const* parameters,
+	size_t parameters_count,
+	char* buffer,
+	size_t size
 );
 
-void free_localizations(
-	struct localization* locs,
-	size_t count
+/* Returns the localization of `key`, or NULL if there is none. */
+struct localization const* localization_lookup(
+	struct localization_table const* table,
+	char const* key
 );
 
 void localize_ui_widgets(
-	struct ui_widget* widgets,
-	struct localization* locs,
-	size_t locs_count
+	struct ui_widget_list widgets,
+	struct localization_table const* table
 );
 
 #endif /*OV2_LOCALIZATION_H*/
@@ -1,9 +1,10 @@
 #include "province_definitions.h"
 #include "game_state.h"
-#include "legacy_ui.h"
 #include "parse.h"
 #include "fs.h"
 #include "ui.h"
+#include "texture.h"
+#include "workers.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_video.h>
 #include <SDL2/SDL_opengl.h>
@@ -73,10 +74,27 @@ static GLenum init_opengl(void) {
 
 int main(int argc, char** argv) {
 	int exit_code = EXIT_SUCCESS;
+	/* The game is run from its directory, the arguments are mods laid over
+	 * it in order. argc is 0 if the program was started without even its
+	 * name. */
+	size_t roots_count = argc > 0 ? (size_t) argc : 1;
+	char const** roots = malloc(roots_count * sizeof(char const*));
+	int i;
 	SDL_Window* window = NULL;
 	SDL_GLContext context = NULL;
 	static const int window_width = 1280;
 	static const int window_height = 1024;
+	/* Time each frame may spend handing decoded textures to GL. */
+	static const double texture_upload_seconds = 0.004;
+
+	if (roots == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the mod list.\n");
+		return EXIT_FAILURE;
+	}
+	roots[0] = ".";
+	for (i = 1; i < argc; i++) {
+		roots[i] = argv[i];
+	}
 
 	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
 		fprintf(stderr, "Video initialization failed: %s\n", SDL_GetError());
@@ -113,23 +131,31 @@ int main(int argc, char** argv) {
 		if ((error = init_opengl()) != GL_NO_ERROR) {
 			fprintf(stderr, "Failed to initialize OpenGL: %s\n", gluErrorString(error));
 			exit_code = EXIT_FAILURE;
-		} else if ((game_state = init_game_state(window_width, window_height)) == NULL) {
+		} else if ((game_state = init_game_state(
+			window_width,
+			window_height,
+			roots,
+			roots_count
+		)) == NULL) {
 			fprintf(stderr, "Failed to initialize game state\n");
 			exit_code = EXIT_FAILURE;
 		} else {
 			while (!game_state->should_quit) {
 				handle_events(game_state);
 				game_tick(game_state);
+				upload_textures(texture_upload_seconds);
 				render(game_state);
 				SDL_GL_SwapWindow(window);
 			}
 		}
 		if (game_state != NULL) free_game_state(game_state);
 	}
+	stop_background_workers();
 
 	if (context != NULL) SDL_GL_DeleteContext(context);
 	if (window != NULL) SDL_DestroyWindow(window);
 	TTF_Quit();
 	SDL_Quit();
+	free(roots);
 	return exit_code;
 }
\ No newline at end of file
@@ -1,4 +1,10 @@
 #include "parse.h"
+#include "lexer.h"
+#include "script.h"
+#include "fs.h"
+#include "intern.h"
+#include "arena.h"
+#include <SDL2/SDL.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -6,146 +12,76 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <assert.h>
-#include <stdarg.h>
 #include <ctype.h>
 #include <math.h>
 #include <limits.h>
+#include <stddef.h>
 
 /* region generic parsing */
 
-struct loc {
-	uint64_t lineno;
-	uint64_t colno;
-};
-
-struct source {
-	char const* name;
-	FILE* file;
-	struct loc loc;
-	char* buf;
-	size_t bufcap;
-	size_t buflen;
-};
-
-static void error(struct source* src, char* fmt, ...) {
-	va_list ap;
-
-	fprintf(stderr, "Syntax error in %s:%lu:%lu: ",
-		src->name, src->loc.lineno,src->loc.colno);
-
-	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
-	va_end(ap);
-
-	fputc('\n', stderr);
-	exit(EXIT_FAILURE);
+static void* calloc_or_die(size_t nmemb, size_t size) {
+	void *result = calloc(nmemb, size);
+	if (result == NULL) {
+		fprintf(stderr, "Failed to allocate: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return result;
 }
 
-static void warning(struct source* src, char* fmt, ...) {
-	va_list ap;
-
-	fprintf(stderr, "Warning in %s:%lu:%lu: ",
-		src->name, src->loc.lineno,src->loc.colno);
-
-	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
-	va_end(ap);
-
-	fputc('\n', stderr);
-}
+/* Definitions are collected into a growable heap array while their enclosing
+ * block is parsed, and copied into the arena once its size is known. Items are
+ * zeroed when pushed and stay in place until the next push. */
+struct builder {
+	char* items;
+	size_t count;
+	size_t capacity;
+	size_t item_size;
+};
 
-static bool is_whitespace(char c) {
-	return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+static void init_builder(struct builder* builder, size_t item_size) {
+	builder->items = NULL;
+	builder->count = 0;
+	builder->capacity = 0;
+	builder->item_size = item_size;
 }
 
-/* Returns false if EOF */
-static bool read_char(struct source* src, char* c) {
-	size_t read = fread(c, 1, 1, src->file);
-	if (read != 1) {
-		if (feof(src->file)) return false;
-		if (ferror(src->file)) {
-			fprintf(stderr, "An error occurred while reading file:"
-					"%s\n", strerror(errno));
+static void* push_item(struct builder* builder) {
+	void* item;
+	if (builder->count == builder->capacity) {
+		size_t capacity = builder->capacity == 0 ? 16 : builder->capacity * 2;
+		char* items = realloc(builder->items, capacity * builder->item_size);
+		if (items == NULL) {
+			fprintf(stderr, "Failed to allocate: %s\n", strerror(errno));
 			exit(EXIT_FAILURE);
 		}
-		assert(0);
+		builder->items = items;
+		builder->capacity = capacity;
 	}
-	return true;
-}
-
-static bool peek_char(struct source* src, char* c, bool ignore_whitespace);
-static bool consume_char(struct source* src, char* c, bool ignore_whitespace);
-
-static void consume_whitespace_and_comments(struct source* src) {
-	char c;
-	do {
-		if (!peek_char(src, &c, false)) return;
-		if (c == '#') {
-			do {
-				if (!consume_char(src, &c, false)) return;
-			} while (c != '\n');
-		} else if (is_whitespace(c) || c == ';') {
-			consume_char(src, &c, false);
-		}
-	} while (is_whitespace(c));
+	item = builder->items + builder->count * builder->item_size;
+	memset(item, 0, builder->item_size);
+	builder->count += 1;
+	return item;
 }
 
-/* Returns false if EOF */
-static bool peek_char(struct source* src, char* c, bool ignore_whitespace) {
-	if (ignore_whitespace) consume_whitespace_and_comments(src);
-
-	if (src->buflen == 0) {
-		if (!read_char(src, c)) return false;
-		if (src->buflen + 2 >= src->bufcap) {
-			src->bufcap += 1;
-			src->buf = realloc(src->buf, src->bufcap);
-			if (!src->buf) {
-				error(src, "Failed to allocate memory: %s",
-				      strerror(errno));
-			}
+/* Returns the `*count` items at `existing` followed by the collected items as
+ * one array in the arena, updates `*count` and frees the builder. */
+static void* finish_items(struct source* src, struct builder* builder,
+                          void const* existing, size_t* count) {
+	size_t size = builder->item_size;
+	size_t total = *count + builder->count;
+	char* items = NULL;
+	if (total > 0) {
+		items = arena_alloc(src->arena, total * size);
+		if (*count > 0) memcpy(items, existing, *count * size);
+		if (builder->count > 0) {
+			memcpy(items + *count * size, builder->items,
+			       builder->count * size);
 		}
-		src->buf[src->buflen] = *c;
-		src->buflen++;
-		src->buf[src->buflen] = 0;
-	}
-	*c = src->buf[0];
-	while (ignore_whitespace && is_whitespace(*c)) {
-		if (!consume_char(src, c, false)) return false;
-		if (!peek_char(src, c, false)) return false;
-	}
-	return true;
-}
-
-/* Returns false if EOF */
-static bool consume_char(struct source* src, char* c, bool ignore_whitespace) {
-	if (ignore_whitespace) consume_whitespace_and_comments(src);
-
-	/* Grab char from buffer or from file */
-	if (src->buflen > 0) {
-		*c = src->buf[0];
-		/* Move buf + '\0' one character backwards, except first char */
-		src->buf = memmove(src->buf, src->buf + 1, src->buflen);
-		src->buflen--;
-	} else {
-		if (!read_char(src, c)) return false;
-	}
-
-	if (*c == '\n') {
-		src->loc.lineno += 1; /* TODO overflow */
-		src->loc.colno = 0;
-	} else {
-		src->loc.colno += 1; /* TODO overflow */
-	}
-	return true;
-}
-
-static void* calloc_or_die(size_t nmemb, size_t size) {
-	void *result = calloc(nmemb, size);
-	if (result == NULL) {
-		fprintf(stderr, "Failed to allocate: %s\n", strerror(errno));
-		exit(EXIT_FAILURE);
 	}
-	return result;
+	free(builder->items);
+	init_builder(builder, size);
+	*count = total;
+	return items;
 }
 
 static void parse_str(struct source* src, char const* target) {
@@ -154,60 +90,40 @@ static void parse_str(struct source* src, char const* target) {
 	char c;
 	for (i = 0; i < len; i++) {
 		if (!consume_char(src, &c, true)) {
-			error(src, "Expected '%s', but got EOF.", target);
+			syntax_error(src, "Expected '%s', but got EOF.", target);
 		}
 		if (tolower(c) != tolower(target[i])) {
-			error(src, "Expected '%s', but got '%c'.", target, c);
+			syntax_error(src, "Expected '%s', but got '%c'.", target, c);
 		}
 	}
 }
 
-static void parse_identifier(struct source* src, char** identifier) {
+static void parse_identifier(struct source* src, char const** identifier) {
+	char const* start;
+	char const* end;
 	char c;
-	size_t size = 2;
-	consume_char(src, &c, true);
-	*identifier = calloc_or_die(2, size);
-	(*identifier)[0] = c;
-	(*identifier)[1] = '\0';
-	for (c = '\0'; peek_char(src, &c, false) && (isalnum(c) || c == '_');) {
-		if (size == SIZE_MAX) {
-			error(src, "Identifier length exeeds %lu.", SIZE_MAX);
-			exit(EXIT_FAILURE);
-		}
-		size += 1;
-		*identifier = realloc(*identifier, size);
-		if (*identifier == NULL) {
-			error(src,"Failed to allocate memory for identifier: "
-				  "%s", strerror(errno));
-		}
-		(*identifier)[size - 2] = (consume_char(src, &c, false), c);
-		(*identifier)[size - 1] = '\0';
-	}
+	if (!peek_char(src, &c, true)) {
+		syntax_error(src, "Expected an identifier, but got EOF.");
+	}
+	/* The first character is taken as is, the rest can not span lines. */
+	start = src->cur;
+	end = skip_identifier(start + 1, src->end);
+	advance_source(src, end);
+	*identifier = intern_n(start, (size_t) (end - start));
 }
 
-static void parse_string_literal(struct source* src, char** str) {
+static void parse_string_literal(struct source* src, char const** str) {
 	char c;
-	size_t size = 1;
 
 	if (peek_char(src, &c, true) && c == '"') {
+		char const* start;
+		char const* end;
 		parse_str(src, "\"");
 
-		(*str) = calloc_or_die(1, size);
-		(*str)[0] = '\0';
-		for (c = '\0'; peek_char(src, &c, false) && c != '"';) {
-			if (size == SIZE_MAX) {
-				error(src, "String length exeeds "
-				      "%lu.", SIZE_MAX);
-			}
-			size += 1;
-			(*str) = realloc(*str, size);
-			if (*str == NULL) {
-				error(src, "Failed to allocate memory for "
-				      "string: %s", strerror(errno));
-			}
-			(*str)[size - 2] = (consume_char(src, &c, false), c);
-			(*str)[size - 1] = '\0';
-		}
+		start = src->cur;
+		end = memchr(start, '"', (size_t) (src->end - start));
+		advance_source(src, end == NULL ? src->end : end);
+		*str = intern_n(start, (size_t) (src->cur - start));
 
 		parse_str(src, "\"");
 	} else {
@@ -215,77 +131,149 @@ static void parse_string_literal(struct source* src, char** str) {
 	}
 }
 
+/* Numbers are the bytes [0-9-] (ints) or [0-9.-] (floats) following the
+ * whitespace, read straight from the mapped file. The common spellings are
+ * converted in place. Anything else, including all malformed literals, goes
+ * through strtol/strtod on a NUL-terminated copy, so values and errors match
+ * the C library exactly. */
+
+static char const* skip_number(char const* cur, char const* end, bool fraction) {
+	while (cur != end && (isdigit((unsigned char) *cur) || *cur == '-'
+	                      || (fraction && *cur == '.'))) {
+		cur++;
+	}
+	return cur;
+}
+
+/* Returns a NUL-terminated copy of [start, end), in `small` if it fits. */
+static char* copy_number(char const* start, char const* end,
+                         char* small, size_t small_size) {
+	size_t len = (size_t) (end - start);
+	char* buf = small;
+	if (len >= small_size) buf = calloc_or_die(len + 1, 1);
+	memcpy(buf, start, len);
+	buf[len] = '\0';
+	return buf;
+}
+
+/* An optional '-' and up to 9 digits, which always fit in a long without
+ * reaching LONG_MAX. */
+static bool convert_int(char const* cur, char const* end, int64_t* i) {
+	bool negative = false;
+	int64_t value = 0;
+	if (cur != end && *cur == '-') {
+		negative = true;
+		cur++;
+	}
+	if (cur == end || end - cur > 9) return false;
+	for (; cur != end; cur++) {
+		if (*cur == '-') return false;
+		value = value * 10 + (*cur - '0');
+	}
+	*i = negative ? -value : value;
+	return true;
+}
+
 static void parse_int_literal(struct source* src, int64_t* i) {
-	char c;
+	char small[64];
 	char* buf;
 	char* endptr;
-	size_t size = 1;
-	buf = calloc_or_die(1, size);
-	buf[0] = '\0';
+	char const* start;
+	char const* end;
 	consume_whitespace_and_comments(src);
-	for (c = '\0'; peek_char(src, &c, false) && (isdigit(c) || c == '-');) {
-		if (c == '_') continue;
-		if (size == SIZE_MAX) {
-			error(src, "Identifier length exeeds %lu.", SIZE_MAX);
-			exit(EXIT_FAILURE);
-		}
-		size += 1;
-		buf = realloc(buf, size);
-		if (buf == NULL) {
-			error(src,"Failed to allocate memory when parsing "
-			      "int: %s", strerror(errno));
-		}
-		buf[size - 2] = (consume_char(src, &c, false), c);
-		buf[size - 1] = '\0';
-	}
+	start = src->cur;
+	end = skip_number(start, src->end, false);
+	advance_source(src, end);
+
+	if (convert_int(start, end, i)) return;
 
+	buf = copy_number(start, end, small, sizeof(small));
 	*i = strtol(buf, &endptr, 10);
 
 	if (*i == LONG_MIN || *i == LONG_MAX) {
-		error(src, "Integer literal '%s' is out of range.", buf);
+		syntax_error(src, "Integer literal '%s' is out of range.", buf);
 	}
 
 	if (*endptr != '\0') {
-		error(src, "Invalid integer literal '%s'.", buf);
+		syntax_error(src, "Invalid integer literal '%s'.", buf);
 	}
 
-	free(buf);
+	if (buf != small) free(buf);
 }
 
+/* Clinger's fast path: up to 15 digits make an exact double, and so does 10^k
+ * for the at most 15 digits after the point, so a single division rounds to
+ * the same value strtod returns. This only holds when doubles are not
+ * evaluated in extended precision. */
+#if (defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ == 0) \
+    || defined(_M_X64) || defined(_M_ARM64)
+static double const powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+	1e13, 1e14, 1e15
+};
+
+/* An optional '-', then digits with at most one '.' among them. */
+static bool convert_float(char const* cur, char const* end, double* f) {
+	bool negative = false;
+	bool seen_point = false;
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int fraction_digits = 0;
+	double value;
+	if (cur != end && *cur == '-') {
+		negative = true;
+		cur++;
+	}
+	for (; cur != end; cur++) {
+		if (*cur == '.' && !seen_point) {
+			seen_point = true;
+		} else if (*cur != '.' && *cur != '-' && digits < 15) {
+			mantissa = mantissa * 10 + (uint64_t) (*cur - '0');
+			digits += 1;
+			if (seen_point) fraction_digits += 1;
+		} else {
+			return false;
+		}
+	}
+	if (digits == 0) return false;
+	value = (double) mantissa / powers_of_ten[fraction_digits];
+	*f = negative ? -value : value;
+	return true;
+}
+#else
+static bool convert_float(char const* cur, char const* end, double* f) {
+	(void) cur;
+	(void) end;
+	(void) f;
+	return false;
+}
+#endif
+
 static void parse_float_literal(struct source* src, double* f) {
-	char c;
+	char small[64];
 	char* buf;
 	char* endptr;
-	size_t size = 1;
-	buf = calloc_or_die(1, size);
+	char const* start;
+	char const* end;
 	consume_whitespace_and_comments(src);
-	buf[0] = '\0';
-	for (c = '\0'; peek_char(src, &c, false)
-	               && (isdigit(c) || c == '-' || c == '.');) {
-		if (c == '_') continue;
-		if (size == SIZE_MAX) {
-			error(src, "Identifier length exeeds %lu.", SIZE_MAX);
-			exit(EXIT_FAILURE);
-		}
-		size += 1;
-		buf = realloc(buf, size);
-		if (buf == NULL) {
-			error(src, "Failed to allocate memory when "
-				   "parsing float: %s", strerror(errno));
-		}
-		buf[size - 2] = (consume_char(src, &c, false), c);
-		buf[size - 1] = '\0';
-	}
+	start = src->cur;
+	end = skip_number(start, src->end, true);
+	advance_source(src, end);
+
+	if (convert_float(start, end, f)) return;
 
+	buf = copy_number(start, end, small, sizeof(small));
 	*f = strtod(buf, &endptr);
 
 	if (*f == HUGE_VAL) {
-		error(src, "Failed to convert to number: %s", strerror(errno));
+		syntax_error(src, "Failed to convert to number: %s", strerror(errno));
 	}
 
 	if (*endptr != '\0') {
-		error(src, "Invalid float literal '%s'.", buf);
+		syntax_error(src, "Invalid float literal '%s'.", buf);
 	}
+
+	if (buf != small) free(buf);
 }
 
 static void parse_bool_literal(struct source* src, bool* value) {
@@ -303,14 +291,14 @@ static void parse_bool_literal(struct source* src, bool* value) {
 		parse_str(src, "no");
 		*value = false;
 	} else {
-		error(src, "Expected '0', '1', 'yes' or 'no', "
+		syntax_error(src, "Expected '0', '1', 'yes' or 'no', "
 		           "but got '%c'.", c);
 	}
 }
 
 static void parse_vec2i(struct source* src, struct vec2i* vec2) {
 	char c = '\0';
-	char* property = NULL;
+	char const* property = NULL;
 	parse_str(src, "{");
 	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
 		parse_identifier(src, &property);
@@ -321,9 +309,8 @@ static void parse_vec2i(struct source* src, struct vec2i* vec2) {
 			parse_str(src, "=");
 			parse_int_literal(src, &vec2->y);
 		} else {
-			error(src, "Unknown property '%s' for vec2.", property);
+			syntax_error(src, "Unknown property '%s' for vec2.", property);
 		}
-		free(property);
 	}
 	parse_str(src, "}");
 }
@@ -349,10 +336,10 @@ static void parse_rgba_hex(struct source* src, struct rgba* rgba) {
 	buf[2] = '\0';
 	value = strtol(buf, &endptr, 16);
 	if (value == LONG_MIN || value == LONG_MAX) {
-		error(src, "Integer literal '%s' is out of range.", buf);
+		syntax_error(src, "Integer literal '%s' is out of range.", buf);
 	}
 	if (*endptr != '\0') {
-		error(src, "Invalid integer literal '%s'.", buf);
+		syntax_error(src, "Invalid integer literal '%s'.", buf);
 	}
 	rgba->a = (float) value / 255.0f;
 
@@ -361,10 +348,10 @@ static void parse_rgba_hex(struct source* src, struct rgba* rgba) {
 	buf[2] = '\0';
 	value = strtol(buf, &endptr, 16);
 	if (value == LONG_MIN || value == LONG_MAX) {
-		error(src, "Integer literal '%s' is out of range.", buf);
+		syntax_error(src, "Integer literal '%s' is out of range.", buf);
 	}
 	if (*endptr != '\0') {
-		error(src, "Invalid integer literal '%s'.", buf);
+		syntax_error(src, "Invalid integer literal '%s'.", buf);
 	}
 	rgba->r = (float) value / 255.0f;
 
@@ -373,10 +360,10 @@ static void parse_rgba_hex(struct source* src, struct rgba* rgba) {
 	buf[2] = '\0';
 	value = strtol(buf, &endptr, 16);
 	if (value == LONG_MIN || value == LONG_MAX) {
-		error(src, "Integer literal '%s' is out of range.", buf);
+		syntax_error(src, "Integer literal '%s' is out of range.", buf);
 	}
 	if (*endptr != '\0') {
-		error(src, "Invalid integer literal '%s'.", buf);
+		syntax_error(src, "Invalid integer literal '%s'.", buf);
 	}
 	rgba->g = (float) value / 255.0f;
 
@@ -385,16 +372,16 @@ static void parse_rgba_hex(struct source* src, struct rgba* rgba) {
 	buf[2] = '\0';
 	value = strtol(buf, &endptr, 16);
 	if (value == LONG_MIN || value == LONG_MAX) {
-		error(src, "Integer literal '%s' is out of range.", buf);
+		syntax_error(src, "Integer literal '%s' is out of range.", buf);
 	}
 	if (*endptr != '\0') {
-		error(src, "Invalid integer literal '%s'.", buf);
+		syntax_error(src, "Invalid integer literal '%s'.", buf);
 	}
 	rgba->b = (float) value / 255.0f;
 }
 
 static void parse_click_sound(struct source* src, enum click_sound* click_sound) {
-	char* identifier = NULL;
+	char const* identifier = NULL;
 	parse_identifier(src, &identifier);
 	if (strcasecmp(identifier, "click") == 0) {
 		*click_sound = CLICK_SOUND_CLICK;
@@ -403,13 +390,12 @@ static void parse_click_sound(struct source* src, enum click_sound* click_sound)
 	} else if (strcasecmp(identifier, "start_game") == 0) {
 		*click_sound = CLICK_SOUND_START_GAME;
 	} else {
-		error(src, "Unknown click sound '%s'.", identifier);
+		syntax_error(src, "Unknown click sound '%s'.", identifier);
 	}
-	free(identifier);
 }
 
 static void parse_load_type(struct source* src, enum sprite_load_type* load_type) {
-	char* identifier = NULL;
+	char const* identifier = NULL;
 	parse_string_literal(src, &identifier);
 	if (strcasecmp(identifier, "ingame") == 0) {
 		*load_type = SPRITE_LOAD_TYPE_INGAME;
@@ -418,443 +404,12 @@ static void parse_load_type(struct source* src, enum sprite_load_type* load_type
 	} else if (strcasecmp(identifier, "frontend") == 0) {
 		*load_type = SPRITE_LOAD_TYPE_FRONTEND;
 	} else {
-		error(src, "Unknown load type '%s'.", identifier);
+		syntax_error(src, "Unknown load type '%s'.", identifier);
 	}
 }
 
-/* endregion */
-
-/* region parse_sprites */
-
-static void parse_line_chart(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_LINE_CHART;
-	sprite->name = NULL;
-	sprite->line_chart.always_transparent = false;
-	sprite->line_chart.line_width = 1;
-	sprite->line_chart.size = (struct vec2i){0, 0};
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &sprite->line_chart.size);
-		} else if (strcasecmp(property, "linewidth") == 0) {
-			parse_int_literal(src, &sprite->line_chart.line_width);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &sprite->line_chart.always_transparent);
-		} else {
-			error(src, "Unknown property '%s' for line_chart_type.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_sprite(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_SIMPLE_SPRITE;
-	sprite->name = NULL;
-	sprite->simple_sprite.texture_file = NULL;
-	sprite->simple_sprite.effect_file = NULL;
-	sprite->simple_sprite.no_of_frames = 1;
-	sprite->simple_sprite.always_transparent = false;
-	sprite->simple_sprite.transparency_check = false;
-	sprite->simple_sprite.no_refcount = false;
-	sprite->simple_sprite.click_sound = CLICK_SOUND_CLICK;
-	sprite->simple_sprite.load_type = SPRITE_LOAD_TYPE_INGAME;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &sprite->simple_sprite.texture_file);
-		} else if (strcasecmp(property, "noofframes") == 0) {
-			parse_int_literal(src, &sprite->simple_sprite.no_of_frames);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &sprite->simple_sprite.always_transparent);
-		} else if (strcasecmp(property, "transparencecheck") == 0) {
-			parse_bool_literal(src, &sprite->simple_sprite.transparency_check);
-		} else if (strcasecmp(property, "norefcount") == 0) {
-			parse_bool_literal(src, &sprite->simple_sprite.no_refcount);
-		} else if (strcasecmp(property, "effectfile") == 0) {
-			parse_string_literal(src, &sprite->simple_sprite.effect_file);
-		} else if (strcasecmp(property, "clicksound") == 0) {
-			parse_click_sound(src, &sprite->simple_sprite.click_sound);
-		} else if (strcasecmp(property, "loadtype") == 0) {
-			parse_load_type(src, &sprite->simple_sprite.load_type);
-		} else {
-			error(src, "Unknown property '%s' for simple_sprite.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_masked_shield(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_MASKED_SHIELD;
-	sprite->name = NULL;
-	sprite->masked_shield.texture_file1 = NULL;
-	sprite->masked_shield.texture_file2 = NULL;
-	sprite->masked_shield.effect_file = false;
-	sprite->masked_shield.always_transparent = false;
-	sprite->masked_shield.flipv = false;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "texturefile1") == 0) {
-			parse_string_literal(src, &sprite->masked_shield.texture_file1);
-		} else if (strcasecmp(property, "texturefile2") == 0) {
-			parse_string_literal(src, &sprite->masked_shield.texture_file2);
-		} else if (strcasecmp(property, "effectfile") == 0) {
-			parse_string_literal(src, &sprite->masked_shield.effect_file);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &sprite->masked_shield.always_transparent);
-		} else if (strcasecmp(property, "flipv") == 0) {
-			parse_bool_literal(src, &sprite->masked_shield.flipv);
-		} else {
-			error(src, "Unknown property '%s' for masked shield.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_progress_bar(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_PROGRESS_BAR;
-	sprite->name = NULL;
-	sprite->progress_bar.color1 = (struct rgb){0, 0, 0};
-	sprite->progress_bar.color2 = (struct rgb){0, 0, 0};
-	sprite->progress_bar.texture_file_1 = NULL;
-	sprite->progress_bar.texture_file_2 = NULL;
-	sprite->progress_bar.size = (struct vec2i){0, 0};
-	sprite->progress_bar.effect_file = NULL;
-	sprite->progress_bar.always_transparent = false;
-	sprite->progress_bar.horizontal = false;
-	sprite->progress_bar.load_type = SPRITE_LOAD_TYPE_INGAME;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "color") == 0) {
-			parse_rgb_float(src, &sprite->progress_bar.color1);
-		} else if (strcasecmp(property, "colortwo") == 0) {
-			parse_rgb_float(src, &sprite->progress_bar.color2);
-		} else if (strcasecmp(property, "texturefile1") == 0) {
-			parse_string_literal(src, &sprite->progress_bar.texture_file_1);
-		} else if (strcasecmp(property, "texturefile2") == 0) {
-			parse_string_literal(src, &sprite->progress_bar.texture_file_2);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &sprite->progress_bar.size);
-		} else if (strcasecmp(property, "effectfile") == 0) {
-			parse_string_literal(src, &sprite->progress_bar.effect_file);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &sprite->progress_bar.always_transparent);
-		} else if (strcasecmp(property, "horizontal") == 0) {
-			parse_bool_literal(src, &sprite->progress_bar.horizontal);
-		} else if (strcasecmp(property, "loadtype") == 0) {
-			parse_load_type(src, &sprite->progress_bar.load_type);
-		} else {
-			error(src, "Unknown property '%s' for progress bar.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_cornered_tile_sprite(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_CORNERED_TILE_SPRITE;
-	sprite->name = NULL;
-	sprite->cornered_tile_sprite.size = (struct vec2i){0, 0};
-	sprite->cornered_tile_sprite.texture_file = NULL;
-	sprite->cornered_tile_sprite.border_size = (struct vec2i){0, 0};
-	sprite->cornered_tile_sprite.load_type = SPRITE_LOAD_TYPE_INGAME;
-	sprite->cornered_tile_sprite.always_transparent = false;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &sprite->cornered_tile_sprite.size);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &sprite->cornered_tile_sprite.texture_file);
-		} else if (strcasecmp(property, "bordersize") == 0) {
-			parse_vec2i(src, &sprite->cornered_tile_sprite.border_size);
-		} else if (strcasecmp(property, "loadtype") == 0) {
-			parse_load_type(src, &sprite->cornered_tile_sprite.load_type);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &sprite->cornered_tile_sprite.always_transparent);
-		} else {
-			error(src, "Unknown property '%s' for cornered tile simple_sprite.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_text_sprite(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_TEXT_SPRITE;
-	sprite->name = NULL;
-	sprite->text_sprite.texture_file = NULL;
-	sprite->text_sprite.no_of_frames = 0;
-	sprite->text_sprite.effect_file = NULL;
-	sprite->text_sprite.no_refcount = false;
-	sprite->text_sprite.load_type = SPRITE_LOAD_TYPE_INGAME;
-	sprite->text_sprite.click_sound = CLICK_SOUND_CLICK;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &sprite->text_sprite.texture_file);
-		} else if (strcasecmp(property, "noofframes") == 0) {
-			parse_int_literal(src, &sprite->text_sprite.no_of_frames);
-		} else if (strcasecmp(property, "effectfile") == 0) {
-			parse_string_literal(src, &sprite->text_sprite.effect_file);
-		} else if (strcasecmp(property, "norefcount") == 0) {
-			parse_bool_literal(src, &sprite->text_sprite.no_refcount);
-		} else if (strcasecmp(property, "loadtype") == 0) {
-			parse_load_type(src, &sprite->text_sprite.load_type);
-		} else if (strcasecmp(property, "clicksound") == 0) {
-			parse_click_sound(src, &sprite->text_sprite.click_sound);
-		} else {
-			error(src, "Unknown property '%s' for text simple_sprite.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_bar_chart(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_BAR_CHART;
-	sprite->name = NULL;
-	sprite->bar_chart.size = (struct vec2i){0, 0};
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &sprite->bar_chart.size);
-		} else {
-			error(src, "Unknown property '%s' for bar chart.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_pie_chart(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_PIE_CHART;
-	sprite->name = NULL;
-	sprite->pie_chart.size = 0;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_int_literal(src, &sprite->pie_chart.size);
-		} else {
-			error(src, "Unknown property '%s' for pie chart.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_tile_sprite(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_TILE_SPRITE;
-	sprite->name = NULL;
-	sprite->tile_sprite.texture_file = NULL;
-	sprite->tile_sprite.effect_file = NULL;
-	sprite->tile_sprite.load_type = SPRITE_LOAD_TYPE_INGAME;
-	sprite->tile_sprite.no_refcount = false;
-	sprite->tile_sprite.size = (struct vec2i){0, 0};
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &sprite->tile_sprite.texture_file);
-		} else if (strcasecmp(property, "effectfile") == 0) {
-			parse_string_literal(src, &sprite->tile_sprite.effect_file);
-		} else if (strcasecmp(property, "loadtype") == 0) {
-			parse_load_type(src, &sprite->tile_sprite.load_type);
-		} else if (strcasecmp(property, "norefcount") == 0) {
-			parse_bool_literal(src, &sprite->tile_sprite.no_refcount);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &sprite->tile_sprite.size);
-		} else {
-			error(src, "Unknown property '%s' for tile simple_sprite.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_scrolling_sprite(struct source* src, struct sprite* sprite) {
-	char c = '\0';
-	sprite->type = TYPE_SCROLLING_SPRITE;
-	sprite->name = NULL;
-	sprite->scrolling_sprite.texture_file1 = NULL;
-	sprite->scrolling_sprite.size = (struct vec2i){0, 0};
-	sprite->scrolling_sprite.effect_file = NULL;
-	sprite->scrolling_sprite.step = 0;
-	sprite->scrolling_sprite.always_transparent = false;
-	parse_str(src, "=");
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &sprite->name);
-		} else if (strcasecmp(property, "texturefile1") == 0) {
-			parse_string_literal(src, &sprite->scrolling_sprite.texture_file1);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &sprite->scrolling_sprite.size);
-		} else if (strcasecmp(property, "effectfile") == 0) {
-			parse_string_literal(src, &sprite->scrolling_sprite.effect_file);
-		} else if (strcasecmp(property, "step") == 0) {
-			parse_int_literal(src, &sprite->scrolling_sprite.step);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &sprite->scrolling_sprite.always_transparent);
-		} else {
-			error(src, "Unknown property '%s' for scrolling simple_sprite.", property);
-		}
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_sprites(struct source* src, struct sprite** sprites) {
-	char c = '\0';
-	parse_str(src, "{");
-
-	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
-		struct sprite* def = calloc_or_die(1, sizeof(struct sprite));
-		char* type = NULL;
-		parse_identifier(src, &type);
-		if (strcasecmp(type, "linecharttype") == 0) {
-			parse_line_chart(src, def);
-		} else if (strcasecmp(type, "spritetype") == 0) {
-			parse_sprite(src, def);
-		} else if (strcasecmp(type, "maskedshieldtype") == 0) {
-			parse_masked_shield(src, def);
-		} else if (strcasecmp(type, "progressbartype") == 0) {
-			parse_progress_bar(src, def);
-		} else if (strcasecmp(type, "corneredtilespritetype") == 0) {
-			parse_cornered_tile_sprite(src, def);
-		} else if (strcasecmp(type, "textspritetype") == 0) {
-			parse_text_sprite(src, def);
-		} else if (strcasecmp(type, "barcharttype") == 0) {
-			parse_bar_chart(src, def);
-		} else if (strcasecmp(type, "piecharttype") == 0) {
-			parse_pie_chart(src, def);
-		} else if (strcasecmp(type, "tilespritetype") == 0) {
-			parse_tile_sprite(src, def);
-		} else if (strcasecmp(type, "scrollingsprite") == 0) {
-			parse_scrolling_sprite(src, def);
-		} else  {
-			error(src, "Unknown simple_sprite type '%s'.", type);
-		}
-		def->next = NULL;
-		if (*sprites == NULL) {
-			*sprites = def;
-		} else {
-			struct sprite* last = *sprites;
-			while (last->next != NULL) {
-				last = last->next;
-			}
-			last->next = def;
-		}
-
-		free(type);
-	}
-
-	parse_str(src, "}");
-}
-/* endregion */
-
-/* region parse_widgets */
-
-static void parse_widget(struct source* src, char const* name, struct ui_widget** widgets);
-
 static void parse_format(struct source* src, enum ui_format* format) {
-	char* identifier = NULL;
+	char const* identifier = NULL;
 	parse_identifier(src, &identifier);
 	if (strcasecmp(identifier, "left") == 0) {
 		*format = UI_FORMAT_LEFT;
@@ -866,12 +421,12 @@ static void parse_format(struct source* src, enum ui_format* format) {
 	} else if (strcasecmp(identifier, "justified") == 0) {
 		*format = UI_FORMAT_JUSTIFIED;
 	} else {
-		error(src, "Unknown text box format '%s'.", identifier);
+		syntax_error(src, "Unknown text box format '%s'.", identifier);
 	}
 }
 
 static void parse_orientation(struct source* src, enum ui_orientation* orientation) {
-	char* str = NULL;
+	char const* str = NULL;
 	parse_string_literal(src, &str);
 	if (strcasecmp(str, "lower_left") == 0) {
 		*orientation = UI_ORIENTATION_LOWER_LEFT;
@@ -888,840 +443,643 @@ static void parse_orientation(struct source* src, enum ui_orientation* orientati
 	} else if (strcasecmp(str, "lower_right") == 0) {
 		*orientation = UI_ORIENTATION_LOWER_RIGHT;
 	} else if (strcasecmp(str, "upperl_left") == 0) {
-		warning(src, "Ignoring misspelled orientation '%s'.", str);
+		syntax_warning(src, "Ignoring misspelled orientation '%s'.", str);
 	} else {
-		error(src, "Unknown orientation '%s'.", str);
+		syntax_error(src, "Unknown orientation '%s'.", str);
 	}
-	free(str);
-}
-
-static void parse_window(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
-
-	widget->type = TYPE_WINDOW;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->window.background = NULL;
-	widget->window.movable = 0;
-	widget->window.dont_render = NULL;
-	widget->window.horizontal_border = NULL;
-	widget->window.vertical_border = NULL;
-	widget->window.full_screen = false;
-	widget->window.children = NULL;
-	widget->window.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->window.up_sound = NULL;
-	widget->window.down_sound = NULL;
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "background") == 0) {
-			parse_string_literal(src, &widget->window.background);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "moveable") == 0) {
-			parse_bool_literal(src, &widget->window.movable);
-		} else if (strcasecmp(property, "dontrender") == 0) {
-			parse_string_literal(src, &widget->window.dont_render);
-		} else if (strcasecmp(property, "horizontalborder") == 0) {
-			parse_string_literal(src, &widget->window.horizontal_border);
-		} else if (strcasecmp(property, "verticalborder") == 0) {
-			parse_string_literal(src, &widget->window.vertical_border);
-		} else if (strcasecmp(property, "fullscreen") == 0) {
-			parse_bool_literal(src, &widget->window.full_screen);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->window.orientation);
-		} else if (strcasecmp(property, "upsound") == 0) {
-			parse_string_literal(src, &widget->window.up_sound);
-		} else if (strcasecmp(property, "downsound") == 0) {
-			parse_string_literal(src, &widget->window.down_sound);
-		} else {
-			parse_widget(src, property, &widget->window.children);
-		}
-		free(property);
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_icon(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
-
-	widget->type = TYPE_ICON;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->icon.sprite = NULL;
-	widget->icon.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->icon.frame = 0;
-	widget->icon.button_mesh = NULL;
-	widget->icon.rotation = 0.0;
-	widget->icon.scale = 0.0;
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "spritetype") == 0) {
-			parse_string_literal(src, &widget->icon.sprite);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->icon.orientation);
-		} else if (strcasecmp(property, "frame") == 0) {
-			parse_int_literal(src, &widget->icon.frame);
-		} else if (strcasecmp(property, "buttonmesh") == 0) {
-			parse_string_literal(src, &widget->icon.button_mesh);
-		} else if (strcasecmp(property, "rotation") == 0) {
-			parse_float_literal(src, &widget->icon.rotation);
-		} else if (strcasecmp(property, "scale") == 0) {
-			parse_float_literal(src, &widget->icon.scale);
-		} else {
-			error(src, "Unknown property '%s' for icon.", property);
-		}
-		peek_char(src, &c, true);
-		free(property);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_button(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
-
-	widget->type = TYPE_BUTTON;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->button.quad_texture_sprite = NULL;
-	widget->button.button_text = NULL;
-	widget->button.button_font = NULL;
-	widget->button.click_sound = CLICK_SOUND_CLICK;
-	widget->button.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->button.tooltip = NULL;
-	widget->button.tooltip_text = NULL;
-	widget->button.delayed_tooltip_text = NULL;
-	widget->button.sprite_type = NULL;
-	widget->button.parent = NULL;
-	widget->button.rotation = 0.0;
-	widget->button.format = UI_FORMAT_LEFT;
-	widget->button.frame = 0;
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "quadtexturesprite") == 0) {
-			parse_string_literal(src, &widget->button.quad_texture_sprite);
-		} else if (strcasecmp(property, "buttontext") == 0) {
-			parse_string_literal(src, &widget->button.button_text);
-		} else if (strcasecmp(property, "buttonfont") == 0) {
-			parse_string_literal(src, &widget->button.button_font);
-		} else if (strcasecmp(property, "shortcut") == 0) {
-			parse_string_literal(src, &widget->button.shortcut);
-		} else if (strcasecmp(property, "clicksound") == 0) {
-			parse_click_sound(src, &widget->button.click_sound);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->button.orientation);
-		} else if (strcasecmp(property, "tooltip") == 0) {
-			parse_string_literal(src, &widget->button.tooltip);
-		} else if (strcasecmp(property, "tooltiptext") == 0) {
-			parse_string_literal(src, &widget->button.tooltip_text);
-		} else if (strcasecmp(property, "delayedtooltiptext") == 0) {
-			parse_string_literal(src, &widget->button.delayed_tooltip_text);
-		} else if (strcasecmp(property, "spritetype") == 0) {
-			parse_string_literal(src, &widget->button.sprite_type);
-		} else if (strcasecmp(property, "parent") == 0) {
-			parse_string_literal(src, &widget->button.parent);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "rotation") == 0) {
-			parse_float_literal(src, &widget->button.rotation);
-		} else if (strcasecmp(property, "format") == 0) {
-			parse_format(src, &widget->button.format);
-		} else {
-			error(src, "Unknown property '%s' for button.", property);
-		}
-		peek_char(src, &c, true);
-		free(property);
-	}
-
-	parse_str(src, "}");
-}
-
-static void parse_text_box(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
-
-	widget->type = TYPE_TEXT_BOX;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->text_box.font = NULL;
-	widget->text_box.border_size = (struct vec2i){0, 0};
-	widget->text_box.text = NULL;
-	widget->text_box.max_width = 0;
-	widget->text_box.max_height = 0;
-	widget->text_box.format = UI_FORMAT_LEFT;
-	widget->text_box.fixed_size = false;
-	widget->text_box.texture_file = NULL;
-	widget->text_box.orientation = UI_ORIENTATION_LOWER_LEFT;
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "font") == 0) {
-			parse_string_literal(src, &widget->text_box.font);
-		} else if (strcasecmp(property, "bordersize") == 0) {
-			parse_vec2i(src, &widget->text_box.border_size);
-		} else if (strcasecmp(property, "text") == 0) {
-			parse_string_literal(src, &widget->text_box.text);
-		} else if (strcasecmp(property, "maxwidth") == 0) {
-			parse_int_literal(src, &widget->text_box.max_width);
-		} else if (strcasecmp(property, "maxheight") == 0) {
-			parse_int_literal(src, &widget->text_box.max_height);
-		} else if (strcasecmp(property, "format") == 0) {
-			parse_format(src, &widget->text_box.format);
-		} else if (strcasecmp(property, "fixedsize") == 0) {
-			parse_bool_literal(src, &widget->text_box.fixed_size);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &widget->text_box.texture_file);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->text_box.orientation);
-		} else {
-			error(src, "Unknown property '%s' for text box.", property);
-		}
-		peek_char(src, &c, true);
-		free(property);
-	}
-
-	parse_str(src, "}");
 }
 
-static void parse_instant_text_box(struct source* src, struct ui_widget* widget) {
+static void parse_color_codes(struct source* src, struct color_code_list* colors) {
+	struct builder builder;
 	char c = '\0';
-
-	widget->type = TYPE_INSTANT_TEXT_BOX;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->instant_text_box.font = NULL;
-	widget->instant_text_box.border_size = (struct vec2i){0, 0};
-	widget->instant_text_box.text = NULL;
-	widget->instant_text_box.max_width = 0;
-	widget->instant_text_box.max_height = 0;
-	widget->instant_text_box.format = UI_FORMAT_LEFT;
-	widget->instant_text_box.fixed_size = false;
-	widget->instant_text_box.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->instant_text_box.texture_file = NULL;
-	widget->instant_text_box.always_transparent = false;
+	init_builder(&builder, sizeof(struct color_code));
 	parse_str(src, "{");
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
+	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
+		struct color_code* color = push_item(&builder);
+		color->name = NULL;
+		color->rgb = (struct rgb){0, 0, 0};
+		parse_identifier(src, &color->name);
 		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "font") == 0) {
-			parse_string_literal(src, &widget->instant_text_box.font);
-		} else if (strcasecmp(property, "bordersize") == 0) {
-			parse_vec2i(src, &widget->instant_text_box.border_size);
-		} else if (strcasecmp(property, "text") == 0) {
-			parse_string_literal(src, &widget->instant_text_box.text);
-		} else if (strcasecmp(property, "maxwidth") == 0) {
-			parse_int_literal(src, &widget->instant_text_box.max_width);
-		} else if (strcasecmp(property, "maxheight") == 0) {
-			parse_int_literal(src, &widget->instant_text_box.max_height);
-		} else if (strcasecmp(property, "format") == 0) {
-			parse_format(src, &widget->instant_text_box.format);
-		} else if (strcasecmp(property, "fixedsize") == 0) {
-			parse_bool_literal(src, &widget->instant_text_box.fixed_size);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->instant_text_box.orientation);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &widget->instant_text_box.texture_file);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &widget->instant_text_box.always_transparent);
-		} else {
-			error(src, "Unknown property '%s' for instant text box.", property);
-		}
-		peek_char(src, &c, true);
-		free(property);
+		parse_rgb_float(src, &color->rgb);
 	}
 
 	parse_str(src, "}");
+	colors->items = finish_items(src, &builder, colors->items, &colors->count);
 }
 
-static void parse_overlapping_elements_box(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+/* endregion */
 
-	widget->type = TYPE_OVERLAPPING_ELEMENTS_BOX;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->overlapping_elements_box.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->overlapping_elements_box.format = UI_FORMAT_LEFT;
-	widget->overlapping_elements_box.spacing = 0;
-	parse_str(src, "{");
+/* region schemas */
+
+/* Every definition type declares its properties as a table of descriptors,
+ * and one engine parses them all. Keys are found through a perfect hash over
+ * the case folded property names, so each key costs a single comparison. */
+
+enum property_kind {
+	PROPERTY_STRING,
+	PROPERTY_INT,
+	PROPERTY_FLOAT,
+	PROPERTY_BOOL,
+	PROPERTY_VEC2I,
+	PROPERTY_RGB,
+	PROPERTY_RGBA_HEX,
+	PROPERTY_CLICK_SOUND,
+	PROPERTY_LOAD_TYPE,
+	PROPERTY_ORIENTATION,
+	PROPERTY_FORMAT,
+	PROPERTY_COLOR_CODES
+};
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->overlapping_elements_box.orientation);
-		} else if (strcasecmp(property, "format") == 0) {
-			parse_format(src, &widget->overlapping_elements_box.format);
-		} else if (strcasecmp(property, "spacing") == 0) {
-			parse_float_literal(src, &widget->overlapping_elements_box.spacing);
-		} else {
-			error(src, "Unknown property '%s' for overlapping elements box.", property);
-		}
-		peek_char(src, &c, true);
-		free(property);
-	}
+struct property {
+	char const* name;
+	size_t offset;
+	enum property_kind kind;
+};
 
-	parse_str(src, "}");
-}
+#define PERFECT_HASH_SLOTS 64
 
-static void parse_scrollbar(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+/* Maps every key of a table to its own slot. Slots hold the index of the
+ * entry plus one, zero marks an empty slot. */
+struct perfect_hash {
+	uint32_t seed;
+	uint32_t mask;
+	unsigned char slots[PERFECT_HASH_SLOTS];
+};
 
-	widget->type = TYPE_SCROLLBAR;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->scrollbar.slider = NULL;
-	widget->scrollbar.track = NULL;
-	widget->scrollbar.left_button = NULL;
-	widget->scrollbar.right_button = NULL;
-	widget->scrollbar.priority = 0;
-	widget->scrollbar.border_size = (struct vec2i){0, 0};
-	widget->scrollbar.max_value = 0.0;
-	widget->scrollbar.min_value = 0.0;
-	widget->scrollbar.step_size = 0.0;
-	widget->scrollbar.start_value = 0.0;
-	widget->scrollbar.horizontal = false;
-	widget->scrollbar.range_limit_min = 0.0;
-	widget->scrollbar.range_limit_max = 0.0;
-	widget->scrollbar.range_limit_min_icon = NULL;
-	widget->scrollbar.range_limit_max_icon = NULL;
-	widget->scrollbar.lockable = false;
-	widget->scrollbar.children = NULL;
-	parse_str(src, "{");
+struct schema {
+	char const* name;
+	/* Used in error messages. */
+	char const* description;
+	/* Stored in the type field of the definition. */
+	int type;
+	struct property const* properties;
+	size_t properties_count;
+	/* Sets the fields whose default is not zero, may be NULL. */
+	void (*init)(void* def);
+	/* Containers take any key that is not a property as a child widget and
+	 * collect them into the ui_widget_list at `children_offset`. */
+	bool has_children;
+	size_t children_offset;
+	struct perfect_hash hash;
+};
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "slider") == 0) {
-			parse_string_literal(src, &widget->scrollbar.slider);
-		} else if (strcasecmp(property, "track") == 0) {
-			parse_string_literal(src, &widget->scrollbar.track);
-		} else if (strcasecmp(property, "leftbutton") == 0) {
-			parse_string_literal(src, &widget->scrollbar.left_button);
-		} else if (strcasecmp(property, "rightbutton") == 0) {
-			parse_string_literal(src, &widget->scrollbar.right_button);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "priority") == 0) {
-			parse_int_literal(src, &widget->scrollbar.priority);
-		} else if (strcasecmp(property, "bordersize") == 0) {
-			parse_vec2i(src, &widget->scrollbar.border_size);
-		} else if (strcasecmp(property, "maxvalue") == 0) {
-			parse_float_literal(src, &widget->scrollbar.max_value);
-		} else if (strcasecmp(property, "minvalue") == 0) {
-			parse_float_literal(src, &widget->scrollbar.min_value);
-		} else if (strcasecmp(property, "stepsize") == 0) {
-			parse_float_literal(src, &widget->scrollbar.step_size);
-		} else if (strcasecmp(property, "startvalue") == 0) {
-			parse_float_literal(src, &widget->scrollbar.start_value);
-		} else if (strcasecmp(property, "horizontal") == 0) {
-			parse_bool_literal(src, &widget->scrollbar.horizontal);
-		} else if (strcasecmp(property, "userangelimit") == 0) {
-			parse_bool_literal(src, &widget->scrollbar.use_range_limit);
-		} else if (strcasecmp(property, "rangelimitmin") == 0) {
-			parse_float_literal(src, &widget->scrollbar.range_limit_min);
-		} else if (strcasecmp(property, "rangelimitmax") == 0) {
-			parse_float_literal(src, &widget->scrollbar.range_limit_max);
-		} else if (strcasecmp(property, "rangelimitminicon") == 0) {
-			parse_string_literal(src, &widget->scrollbar.range_limit_min_icon);
-		} else if (strcasecmp(property, "rangelimitmaxicon") == 0) {
-			parse_string_literal(src, &widget->scrollbar.range_limit_max_icon);
-		} else if (strcasecmp(property, "lockable") == 0) {
-			parse_bool_literal(src, &widget->scrollbar.lockable);
-		} else {
-			parse_widget(src, property, &widget->scrollbar.children);
-		}
-		free(property);
-		peek_char(src, &c, true);
-	}
+struct schema_set {
+	struct schema* schemas;
+	size_t count;
+	struct perfect_hash hash;
+};
 
-	parse_str(src, "}");
+static uint32_t hash_key(char const* key, uint32_t seed) {
+	uint32_t hash = 2166136261u ^ seed;
+	for (; *key != '\0'; key++) {
+		/* Folds letters to lower case, keys only contain [a-z0-9_]. */
+		hash ^= (unsigned char) (*key | 0x20);
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 16);
 }
 
-static void parse_checkbox(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+/* The entries are `stride` bytes apart and start with their key. */
+static char const* entry_key(void const* entries, size_t stride, size_t index) {
+	return *(char const* const*) ((char const*) entries + index * stride);
+}
 
-	widget->type = TYPE_CHECKBOX;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->checkbox.quad_texture_sprite = NULL;
-	widget->checkbox.tooltip = NULL;
-	widget->checkbox.tooltip_text = NULL;
-	widget->checkbox.delayed_tooltip_text = NULL;
-	widget->checkbox.button_text = NULL;
-	widget->checkbox.button_font = NULL;
-	widget->checkbox.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->checkbox.shortcut = NULL;
-	parse_str(src, "{");
+/* Searches for the first seed that places every key in a slot of its own.
+ * Tables are at least twice as large as the key count, which keeps the search
+ * down to a few dozen seeds. */
+static void build_perfect_hash(struct perfect_hash* hash, void const* entries,
+                               size_t count, size_t stride) {
+	size_t size;
+	uint32_t seed;
+	size_t i;
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "quadtexturesprite") == 0) {
-			parse_string_literal(src, &widget->checkbox.quad_texture_sprite);
-		} else if (strcasecmp(property, "tooltip") == 0) {
-			parse_string_literal(src, &widget->checkbox.tooltip);
-		} else if (strcasecmp(property, "tooltiptext") == 0) {
-			parse_string_literal(src, &widget->checkbox.tooltip_text);
-		} else if (strcasecmp(property, "delayedtooltiptext") == 0) {
-			parse_string_literal(src, &widget->checkbox.delayed_tooltip_text);
-		} else if (strcasecmp(property, "buttontext") == 0) {
-			parse_string_literal(src, &widget->checkbox.button_text);
-		} else if (strcasecmp(property, "buttonfont") == 0) {
-			parse_string_literal(src, &widget->checkbox.button_font);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->checkbox.orientation);
-		} else if (strcasecmp(property, "shortcut") == 0) {
-			parse_string_literal(src, &widget->checkbox.shortcut);
-		} else {
-			error(src, "Unknown property '%s' for checkbox.", property);
+	for (size = 1; size < 2 * count; size *= 2);
+	for (; size <= PERFECT_HASH_SLOTS; size *= 2) {
+		for (seed = 0; seed < 100000; seed++) {
+			memset(hash->slots, 0, sizeof(hash->slots));
+			for (i = 0; i < count; i++) {
+				size_t slot = hash_key(entry_key(entries, stride, i), seed) & (size - 1);
+				if (hash->slots[slot] != 0) break;
+				hash->slots[slot] = (unsigned char) (i + 1);
+			}
+			if (i == count) {
+				hash->seed = seed;
+				hash->mask = (uint32_t) (size - 1);
+				return;
+			}
 		}
-		peek_char(src, &c, true);
-		free(property);
 	}
+	fprintf(stderr, "Failed to build a perfect hash for '%s'.\n",
+	        entry_key(entries, stride, 0));
+	exit(EXIT_FAILURE);
+}
 
-	parse_str(src, "}");
+/* Returns `count` if `key` is not in the table. */
+static size_t find_key(struct perfect_hash const* hash, void const* entries,
+                       size_t count, size_t stride, char const* key) {
+	size_t index = hash->slots[hash_key(key, hash->seed) & hash->mask];
+	if (index == 0) return count;
+	index -= 1;
+	if (strcasecmp(entry_key(entries, stride, index), key) != 0) return count;
+	return index;
 }
 
-static void parse_edit_box(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+static struct property const* find_property(struct schema const* schema, char const* key) {
+	size_t i = find_key(&schema->hash, schema->properties,
+	                    schema->properties_count, sizeof(struct property), key);
+	return i < schema->properties_count ? &schema->properties[i] : NULL;
+}
 
-	widget->type = TYPE_EDIT_BOX;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->edit_box.texture_file = NULL;
-	widget->edit_box.font = NULL;
-	widget->edit_box.border_size = (struct vec2i){0, 0};
-	widget->edit_box.text = NULL;
-	widget->edit_box.orientation = UI_ORIENTATION_LOWER_LEFT;
-	parse_str(src, "{");
+static struct schema const* find_schema(struct schema_set const* set, char const* key) {
+	size_t i = find_key(&set->hash, set->schemas, set->count,
+	                    sizeof(struct schema), key);
+	return i < set->count ? &set->schemas[i] : NULL;
+}
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "texturefile") == 0) {
-			parse_string_literal(src, &widget->edit_box.texture_file);
-		} else if (strcasecmp(property, "font") == 0) {
-			parse_string_literal(src, &widget->edit_box.font);
-		} else if (strcasecmp(property, "bordersize") == 0) {
-			parse_vec2i(src, &widget->edit_box.border_size);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "text") == 0) {
-			parse_string_literal(src, &widget->edit_box.text);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->edit_box.orientation);
-		} else {
-			error(src, "Unknown property '%s' for edit box.", property);
-		}
-		peek_char(src, &c, true);
-		free(property);
+static void parse_widget(struct source* src, char const* name, struct builder* widgets);
+
+static void parse_value(struct source* src, enum property_kind kind, void* value) {
+	switch (kind) {
+	case PROPERTY_STRING:
+		parse_string_literal(src, value);
+		break;
+	case PROPERTY_INT:
+		parse_int_literal(src, value);
+		break;
+	case PROPERTY_FLOAT:
+		parse_float_literal(src, value);
+		break;
+	case PROPERTY_BOOL:
+		parse_bool_literal(src, value);
+		break;
+	case PROPERTY_VEC2I:
+		parse_vec2i(src, value);
+		break;
+	case PROPERTY_RGB:
+		parse_rgb_float(src, value);
+		break;
+	case PROPERTY_RGBA_HEX:
+		parse_rgba_hex(src, value);
+		break;
+	case PROPERTY_CLICK_SOUND:
+		parse_click_sound(src, value);
+		break;
+	case PROPERTY_LOAD_TYPE:
+		parse_load_type(src, value);
+		break;
+	case PROPERTY_ORIENTATION:
+		parse_orientation(src, value);
+		break;
+	case PROPERTY_FORMAT:
+		parse_format(src, value);
+		break;
+	case PROPERTY_COLOR_CODES:
+		parse_color_codes(src, value);
+		break;
+	default:
+		assert(0);
 	}
-
-	parse_str(src, "}");
 }
 
-static void parse_list_box(struct source* src, struct ui_widget* widget) {
+/* Parses a `{ key = value ... }` block into the zeroed definition `def`. */
+static void parse_properties(struct source* src, struct schema const* schema, void* def) {
+	struct builder children;
 	char c = '\0';
-
-	widget->type = TYPE_LIST_BOX;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->list_box.background = NULL;
-	widget->list_box.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->list_box.spacing = 0;
-	widget->list_box.scrollbar_type = NULL;
-	widget->list_box.border_size = (struct vec2i){0, 0};
-	widget->list_box.priority = 0;
-	widget->list_box.step = 0;
-	widget->list_box.horizontal = false;
-	widget->list_box.offset = (struct vec2i){0, 0};
-	widget->list_box.always_transparent = false;
+	init_builder(&children, sizeof(struct ui_widget));
+	if (schema->init != NULL) schema->init(def);
 	parse_str(src, "{");
 
 	peek_char(src, &c, true);
 	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
+		char const* key = NULL;
+		struct property const* property;
+		parse_identifier(src, &key);
 		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "background") == 0) {
-			parse_string_literal(src, &widget->list_box.background);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->list_box.orientation);
-		} else if (strcasecmp(property, "spacing") == 0) {
-			parse_int_literal(src, &widget->list_box.spacing);
-		} else if (strcasecmp(property, "scrollbartype") == 0) {
-			parse_string_literal(src, &widget->list_box.scrollbar_type);
-		} else if (strcasecmp(property, "bordersize") == 0) {
-			parse_vec2i(src, &widget->list_box.border_size);
-		} else if (strcasecmp(property, "priority") == 0) {
-			parse_int_literal(src, &widget->list_box.priority);
-		} else if (strcasecmp(property, "step") == 0) {
-			parse_int_literal(src, &widget->list_box.step);
-		} else if (strcasecmp(property, "horizontal") == 0) {
-			parse_bool_literal(src, &widget->list_box.horizontal);
-		} else if (strcasecmp(property, "offset") == 0) {
-			parse_vec2i(src, &widget->list_box.offset);
-		} else if (strcasecmp(property, "allwaystransparent") == 0) {
-			parse_bool_literal(src, &widget->list_box.always_transparent);
+		property = find_property(schema, key);
+		if (property != NULL) {
+			parse_value(src, property->kind, (char*) def + property->offset);
+		} else if (schema->has_children) {
+			parse_widget(src, key, &children);
 		} else {
-			error(src, "Unknown property '%s' for list box.", property);
+			syntax_error(src, "Unknown property '%s' for %s.", key, schema->description);
 		}
 		peek_char(src, &c, true);
-		free(property);
 	}
 
 	parse_str(src, "}");
+	if (schema->has_children) {
+		struct ui_widget_list* list =
+			(struct ui_widget_list*) ((char*) def + schema->children_offset);
+		list->items = finish_items(src, &children, list->items, &list->count);
+	}
 }
 
-static void parse_eu3_dialog(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+#define PROPERTIES(table) table, sizeof(table) / sizeof(table[0])
+#define SPRITE(field) offsetof(struct sprite, field)
+#define WIDGET(field) offsetof(struct ui_widget, field)
 
-	widget->type = TYPE_EU3_DIALOG;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->eu3_dialog.background = NULL;
-	widget->eu3_dialog.movable = 0;
-	widget->eu3_dialog.dont_render = NULL;
-	widget->eu3_dialog.horizontal_border = NULL;
-	widget->eu3_dialog.vertical_border = NULL;
-	widget->eu3_dialog.full_screen = false;
-	widget->eu3_dialog.orientation = UI_ORIENTATION_LOWER_LEFT;
-	widget->eu3_dialog.children = NULL;
-	parse_str(src, "{");
+/* endregion */
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "background") == 0) {
-			parse_string_literal(src, &widget->eu3_dialog.background);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "size") == 0) {
-			parse_vec2i(src, &widget->size);
-		} else if (strcasecmp(property, "moveable") == 0) {
-			parse_bool_literal(src, &widget->eu3_dialog.movable);
-		} else if (strcasecmp(property, "dontrender") == 0) {
-			parse_string_literal(src, &widget->eu3_dialog.dont_render);
-		} else if (strcasecmp(property, "horizontalborder") == 0) {
-			parse_string_literal(src, &widget->eu3_dialog.horizontal_border);
-		} else if (strcasecmp(property, "verticalborder") == 0) {
-			parse_string_literal(src, &widget->eu3_dialog.vertical_border);
-		} else if (strcasecmp(property, "fullscreen") == 0) {
-			parse_bool_literal(src, &widget->eu3_dialog.full_screen);
-		} else if (strcasecmp(property, "orientation") == 0) {
-			parse_orientation(src, &widget->eu3_dialog.orientation);
-		} else {
-			parse_widget(src, property, &widget->eu3_dialog.children);
-		}
-		free(property);
-		peek_char(src, &c, true);
-	}
+/* region parse_sprites */
 
-	parse_str(src, "}");
-}
+static struct property const simple_sprite_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"texturefile", SPRITE(simple_sprite.texture_file), PROPERTY_STRING},
+	{"noofframes", SPRITE(simple_sprite.no_of_frames), PROPERTY_INT},
+	{"allwaystransparent", SPRITE(simple_sprite.always_transparent), PROPERTY_BOOL},
+	{"transparencecheck", SPRITE(simple_sprite.transparency_check), PROPERTY_BOOL},
+	{"norefcount", SPRITE(simple_sprite.no_refcount), PROPERTY_BOOL},
+	{"effectfile", SPRITE(simple_sprite.effect_file), PROPERTY_STRING},
+	{"clicksound", SPRITE(simple_sprite.click_sound), PROPERTY_CLICK_SOUND},
+	{"loadtype", SPRITE(simple_sprite.load_type), PROPERTY_LOAD_TYPE}
+};
 
-static void parse_shield(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+static struct property const line_chart_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"size", SPRITE(line_chart.size), PROPERTY_VEC2I},
+	{"linewidth", SPRITE(line_chart.line_width), PROPERTY_INT},
+	{"allwaystransparent", SPRITE(line_chart.always_transparent), PROPERTY_BOOL}
+};
 
-	widget->type = TYPE_SHIELD;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	widget->shield.sprite_type = NULL;
-	widget->shield.rotation = 0;
-	parse_str(src, "{");
+static struct property const masked_shield_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"texturefile1", SPRITE(masked_shield.texture_file1), PROPERTY_STRING},
+	{"texturefile2", SPRITE(masked_shield.texture_file2), PROPERTY_STRING},
+	{"effectfile", SPRITE(masked_shield.effect_file), PROPERTY_STRING},
+	{"allwaystransparent", SPRITE(masked_shield.always_transparent), PROPERTY_BOOL},
+	{"flipv", SPRITE(masked_shield.flipv), PROPERTY_BOOL}
+};
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "spritetype") == 0) {
-			parse_string_literal(src, &widget->shield.sprite_type);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else if (strcasecmp(property, "rotation") == 0) {
-			parse_float_literal(src, &widget->shield.rotation);
-		} else {
-			error(src, "Unknown property '%s' for shield.", property);
-		}
-		free(property);
-		peek_char(src, &c, true);
-	}
+static struct property const progress_bar_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"color", SPRITE(progress_bar.color1), PROPERTY_RGB},
+	{"colortwo", SPRITE(progress_bar.color2), PROPERTY_RGB},
+	{"texturefile1", SPRITE(progress_bar.texture_file_1), PROPERTY_STRING},
+	{"texturefile2", SPRITE(progress_bar.texture_file_2), PROPERTY_STRING},
+	{"size", SPRITE(progress_bar.size), PROPERTY_VEC2I},
+	{"effectfile", SPRITE(progress_bar.effect_file), PROPERTY_STRING},
+	{"allwaystransparent", SPRITE(progress_bar.always_transparent), PROPERTY_BOOL},
+	{"horizontal", SPRITE(progress_bar.horizontal), PROPERTY_BOOL},
+	{"loadtype", SPRITE(progress_bar.load_type), PROPERTY_LOAD_TYPE}
+};
 
-	parse_str(src, "}");
-}
+static struct property const cornered_tile_sprite_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"size", SPRITE(cornered_tile_sprite.size), PROPERTY_VEC2I},
+	{"texturefile", SPRITE(cornered_tile_sprite.texture_file), PROPERTY_STRING},
+	{"bordersize", SPRITE(cornered_tile_sprite.border_size), PROPERTY_VEC2I},
+	{"loadtype", SPRITE(cornered_tile_sprite.load_type), PROPERTY_LOAD_TYPE},
+	{"allwaystransparent", SPRITE(cornered_tile_sprite.always_transparent), PROPERTY_BOOL}
+};
 
-static void parse_position(struct source* src, struct ui_widget* widget) {
-	char c = '\0';
+static struct property const text_sprite_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"texturefile", SPRITE(text_sprite.texture_file), PROPERTY_STRING},
+	{"noofframes", SPRITE(text_sprite.no_of_frames), PROPERTY_INT},
+	{"effectfile", SPRITE(text_sprite.effect_file), PROPERTY_STRING},
+	{"norefcount", SPRITE(text_sprite.no_refcount), PROPERTY_BOOL},
+	{"loadtype", SPRITE(text_sprite.load_type), PROPERTY_LOAD_TYPE},
+	{"clicksound", SPRITE(text_sprite.click_sound), PROPERTY_CLICK_SOUND}
+};
 
-	widget->type = TYPE_POSITION;
-	widget->name = NULL;
-	widget->position = (struct vec2i){0, 0};
-	widget->size = (struct vec2i){0, 0};
-	parse_str(src, "{");
+static struct property const bar_chart_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"size", SPRITE(bar_chart.size), PROPERTY_VEC2I}
+};
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &widget->name);
-		} else if (strcasecmp(property, "position") == 0) {
-			parse_vec2i(src, &widget->position);
-		} else {
-			error(src, "Unknown property '%s' for position.", property);
-		}
-		free(property);
-		peek_char(src, &c, true);
-	}
+static struct property const pie_chart_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"size", SPRITE(pie_chart.size), PROPERTY_INT}
+};
 
-	parse_str(src, "}");
+static struct property const tile_sprite_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"texturefile", SPRITE(tile_sprite.texture_file), PROPERTY_STRING},
+	{"effectfile", SPRITE(tile_sprite.effect_file), PROPERTY_STRING},
+	{"loadtype", SPRITE(tile_sprite.load_type), PROPERTY_LOAD_TYPE},
+	{"norefcount", SPRITE(tile_sprite.no_refcount), PROPERTY_BOOL},
+	{"size", SPRITE(tile_sprite.size), PROPERTY_VEC2I}
+};
+
+static struct property const scrolling_sprite_properties[] = {
+	{"name", SPRITE(name), PROPERTY_STRING},
+	{"texturefile1", SPRITE(scrolling_sprite.texture_file1), PROPERTY_STRING},
+	{"size", SPRITE(scrolling_sprite.size), PROPERTY_VEC2I},
+	{"effectfile", SPRITE(scrolling_sprite.effect_file), PROPERTY_STRING},
+	{"step", SPRITE(scrolling_sprite.step), PROPERTY_INT},
+	{"allwaystransparent", SPRITE(scrolling_sprite.always_transparent), PROPERTY_BOOL}
+};
+
+static void init_simple_sprite(void* def) {
+	((struct sprite*) def)->simple_sprite.no_of_frames = 1;
 }
 
-static void parse_widget(struct source* src, char const* name, struct ui_widget** widgets) {
-	struct ui_widget* widget = calloc_or_die(1, sizeof(struct ui_widget));
-	if (strcasecmp(name, "windowtype") == 0) {
-		parse_window(src, widget);
-	} else if (strcasecmp(name, "icontype") == 0) {
-		parse_icon(src, widget);
-	} else if (strcasecmp(name, "guibuttontype") == 0) {
-		parse_button(src, widget);
-	} else if (strcasecmp(name, "textboxtype") == 0) {
-		parse_text_box(src, widget);
-	} else if (strcasecmp(name, "instanttextboxtype") == 0) {
-		parse_instant_text_box(src, widget);
-	} else if (strcasecmp(name, "overlappingelementsboxtype") == 0) {
-		parse_overlapping_elements_box(src, widget);
-	} else if (strcasecmp(name, "scrollbartype") == 0) {
-		parse_scrollbar(src, widget);
-	} else if (strcasecmp(name, "checkboxtype") == 0) {
-		parse_checkbox(src, widget);
-	} else if (strcasecmp(name, "editboxtype") == 0) {
-		parse_edit_box(src, widget);
-	} else if (strcasecmp(name, "listboxtype") == 0) {
-		parse_list_box(src, widget);
-	} else if (strcasecmp(name, "eu3dialogtype") == 0) {
-		parse_eu3_dialog(src, widget);
-	} else if (strcasecmp(name, "shieldtype") == 0) {
-		parse_shield(src, widget);
-	} else if (strcasecmp(name, "positiontype") == 0) {
-		parse_position(src, widget);
-	} else {
-		error(src, "Unknown gui type_name '%s'.", name);
-	}
-	/* Add to the end of the list */
-	widget->next = NULL;
-	if (*widgets == NULL) {
-		*widgets = widget;
-	} else {
-		struct ui_widget* last = *widgets;
-		while (last->next != NULL) {
-			last = last->next;
-		}
-		last->next = widget;
-	}
+static void init_line_chart(void* def) {
+	((struct sprite*) def)->line_chart.line_width = 1;
 }
 
-static void parse_widgets(struct source* src, struct ui_widget** widgets) {
+static struct schema sprite_schemas[] = {
+	{"linecharttype", "line_chart_type", TYPE_LINE_CHART,
+	 PROPERTIES(line_chart_properties), init_line_chart, false, 0},
+	{"spritetype", "simple_sprite", TYPE_SIMPLE_SPRITE,
+	 PROPERTIES(simple_sprite_properties), init_simple_sprite, false, 0},
+	{"maskedshieldtype", "masked shield", TYPE_MASKED_SHIELD,
+	 PROPERTIES(masked_shield_properties), NULL, false, 0},
+	{"progressbartype", "progress bar", TYPE_PROGRESS_BAR,
+	 PROPERTIES(progress_bar_properties), NULL, false, 0},
+	{"corneredtilespritetype", "cornered tile simple_sprite", TYPE_CORNERED_TILE_SPRITE,
+	 PROPERTIES(cornered_tile_sprite_properties), NULL, false, 0},
+	{"textspritetype", "text simple_sprite", TYPE_TEXT_SPRITE,
+	 PROPERTIES(text_sprite_properties), NULL, false, 0},
+	{"barcharttype", "bar chart", TYPE_BAR_CHART,
+	 PROPERTIES(bar_chart_properties), NULL, false, 0},
+	{"piecharttype", "pie chart", TYPE_PIE_CHART,
+	 PROPERTIES(pie_chart_properties), NULL, false, 0},
+	{"tilespritetype", "tile simple_sprite", TYPE_TILE_SPRITE,
+	 PROPERTIES(tile_sprite_properties), NULL, false, 0},
+	{"scrollingsprite", "scrolling simple_sprite", TYPE_SCROLLING_SPRITE,
+	 PROPERTIES(scrolling_sprite_properties), NULL, false, 0}
+};
+
+static struct schema_set sprite_types = {PROPERTIES(sprite_schemas)};
+
+static void parse_sprites(struct source* src, struct builder* sprites) {
 	char c = '\0';
 	parse_str(src, "{");
 
 	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
-		char* property = NULL;
-		parse_identifier(src, &property);
+		struct schema const* schema;
+		struct sprite* def;
+		char const* type = NULL;
+		parse_identifier(src, &type);
+		schema = find_schema(&sprite_types, type);
+		if (schema == NULL) {
+			syntax_error(src, "Unknown simple_sprite type '%s'.", type);
+		}
+		def = push_item(sprites);
+		def->type = schema->type;
 		parse_str(src, "=");
-		parse_widget(src, property, widgets);
-		free(property);
+		parse_properties(src, schema, def);
 	}
 
 	parse_str(src, "}");
 }
 /* endregion */
 
-/* region parse_bitmap_fonts */
+/* region parse_widgets */
 
-static void parse_color_codes(struct source* src, struct color_codes** colors) {
-	char c = '\0';
-	parse_str(src, "{");
+static struct property const window_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"background", WIDGET(window.background), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"moveable", WIDGET(window.movable), PROPERTY_BOOL},
+	{"dontrender", WIDGET(window.dont_render), PROPERTY_STRING},
+	{"horizontalborder", WIDGET(window.horizontal_border), PROPERTY_STRING},
+	{"verticalborder", WIDGET(window.vertical_border), PROPERTY_STRING},
+	{"fullscreen", WIDGET(window.full_screen), PROPERTY_BOOL},
+	{"orientation", WIDGET(window.orientation), PROPERTY_ORIENTATION},
+	{"upsound", WIDGET(window.up_sound), PROPERTY_STRING},
+	{"downsound", WIDGET(window.down_sound), PROPERTY_STRING}
+};
 
-	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
-		struct color_codes* color =
-			calloc_or_die(1, sizeof(struct color_codes));
-		color->name = NULL;
-		color->rgb = (struct rgb){0, 0, 0};
-		color->next = NULL;
-		parse_identifier(src, &color->name);
-		parse_str(src, "=");
-		parse_rgb_float(src, &color->rgb);
+static struct property const icon_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"spritetype", WIDGET(icon.sprite), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"orientation", WIDGET(icon.orientation), PROPERTY_ORIENTATION},
+	{"frame", WIDGET(icon.frame), PROPERTY_INT},
+	{"buttonmesh", WIDGET(icon.button_mesh), PROPERTY_STRING},
+	{"rotation", WIDGET(icon.rotation), PROPERTY_FLOAT},
+	{"scale", WIDGET(icon.scale), PROPERTY_FLOAT}
+};
 
-		/* Add to the end of the list */
-		color->next = NULL;
-		if (*colors == NULL) {
-			*colors = color;
-		} else {
-			struct color_codes* last = *colors;
-			while (last->next != NULL) {
-				last = last->next;
-			}
-			last->next = color;
-		}
-	}
+static struct property const button_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"quadtexturesprite", WIDGET(button.quad_texture_sprite), PROPERTY_STRING},
+	{"buttontext", WIDGET(button.button_text), PROPERTY_STRING},
+	{"buttonfont", WIDGET(button.button_font), PROPERTY_STRING},
+	{"shortcut", WIDGET(button.shortcut), PROPERTY_STRING},
+	{"clicksound", WIDGET(button.click_sound), PROPERTY_CLICK_SOUND},
+	{"orientation", WIDGET(button.orientation), PROPERTY_ORIENTATION},
+	{"tooltip", WIDGET(button.tooltip), PROPERTY_STRING},
+	{"tooltiptext", WIDGET(button.tooltip_text), PROPERTY_STRING},
+	{"delayedtooltiptext", WIDGET(button.delayed_tooltip_text), PROPERTY_STRING},
+	{"spritetype", WIDGET(button.sprite_type), PROPERTY_STRING},
+	{"parent", WIDGET(button.parent), PROPERTY_STRING},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"rotation", WIDGET(button.rotation), PROPERTY_FLOAT},
+	{"format", WIDGET(button.format), PROPERTY_FORMAT}
+};
 
-	parse_str(src, "}");
+static struct property const text_box_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"font", WIDGET(text_box.font), PROPERTY_STRING},
+	{"bordersize", WIDGET(text_box.border_size), PROPERTY_VEC2I},
+	{"text", WIDGET(text_box.text), PROPERTY_STRING},
+	{"maxwidth", WIDGET(text_box.max_width), PROPERTY_INT},
+	{"maxheight", WIDGET(text_box.max_height), PROPERTY_INT},
+	{"format", WIDGET(text_box.format), PROPERTY_FORMAT},
+	{"fixedsize", WIDGET(text_box.fixed_size), PROPERTY_BOOL},
+	{"texturefile", WIDGET(text_box.texture_file), PROPERTY_STRING},
+	{"orientation", WIDGET(text_box.orientation), PROPERTY_ORIENTATION}
+};
+
+static struct property const instant_text_box_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"font", WIDGET(instant_text_box.font), PROPERTY_STRING},
+	{"bordersize", WIDGET(instant_text_box.border_size), PROPERTY_VEC2I},
+	{"text", WIDGET(instant_text_box.text), PROPERTY_STRING},
+	{"maxwidth", WIDGET(instant_text_box.max_width), PROPERTY_INT},
+	{"maxheight", WIDGET(instant_text_box.max_height), PROPERTY_INT},
+	{"format", WIDGET(instant_text_box.format), PROPERTY_FORMAT},
+	{"fixedsize", WIDGET(instant_text_box.fixed_size), PROPERTY_BOOL},
+	{"orientation", WIDGET(instant_text_box.orientation), PROPERTY_ORIENTATION},
+	{"texturefile", WIDGET(instant_text_box.texture_file), PROPERTY_STRING},
+	{"allwaystransparent", WIDGET(instant_text_box.always_transparent), PROPERTY_BOOL}
+};
+
+static struct property const overlapping_elements_box_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"orientation", WIDGET(overlapping_elements_box.orientation), PROPERTY_ORIENTATION},
+	{"format", WIDGET(overlapping_elements_box.format), PROPERTY_FORMAT},
+	{"spacing", WIDGET(overlapping_elements_box.spacing), PROPERTY_FLOAT}
+};
+
+static struct property const scrollbar_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"slider", WIDGET(scrollbar.slider), PROPERTY_STRING},
+	{"track", WIDGET(scrollbar.track), PROPERTY_STRING},
+	{"leftbutton", WIDGET(scrollbar.left_button), PROPERTY_STRING},
+	{"rightbutton", WIDGET(scrollbar.right_button), PROPERTY_STRING},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"priority", WIDGET(scrollbar.priority), PROPERTY_INT},
+	{"bordersize", WIDGET(scrollbar.border_size), PROPERTY_VEC2I},
+	{"maxvalue", WIDGET(scrollbar.max_value), PROPERTY_FLOAT},
+	{"minvalue", WIDGET(scrollbar.min_value), PROPERTY_FLOAT},
+	{"stepsize", WIDGET(scrollbar.step_size), PROPERTY_FLOAT},
+	{"startvalue", WIDGET(scrollbar.start_value), PROPERTY_FLOAT},
+	{"horizontal", WIDGET(scrollbar.horizontal), PROPERTY_BOOL},
+	{"userangelimit", WIDGET(scrollbar.use_range_limit), PROPERTY_BOOL},
+	{"rangelimitmin", WIDGET(scrollbar.range_limit_min), PROPERTY_FLOAT},
+	{"rangelimitmax", WIDGET(scrollbar.range_limit_max), PROPERTY_FLOAT},
+	{"rangelimitminicon", WIDGET(scrollbar.range_limit_min_icon), PROPERTY_STRING},
+	{"rangelimitmaxicon", WIDGET(scrollbar.range_limit_max_icon), PROPERTY_STRING},
+	{"lockable", WIDGET(scrollbar.lockable), PROPERTY_BOOL}
+};
+
+static struct property const checkbox_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"quadtexturesprite", WIDGET(checkbox.quad_texture_sprite), PROPERTY_STRING},
+	{"tooltip", WIDGET(checkbox.tooltip), PROPERTY_STRING},
+	{"tooltiptext", WIDGET(checkbox.tooltip_text), PROPERTY_STRING},
+	{"delayedtooltiptext", WIDGET(checkbox.delayed_tooltip_text), PROPERTY_STRING},
+	{"buttontext", WIDGET(checkbox.button_text), PROPERTY_STRING},
+	{"buttonfont", WIDGET(checkbox.button_font), PROPERTY_STRING},
+	{"orientation", WIDGET(checkbox.orientation), PROPERTY_ORIENTATION},
+	{"shortcut", WIDGET(checkbox.shortcut), PROPERTY_STRING}
+};
+
+static struct property const edit_box_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"texturefile", WIDGET(edit_box.texture_file), PROPERTY_STRING},
+	{"font", WIDGET(edit_box.font), PROPERTY_STRING},
+	{"bordersize", WIDGET(edit_box.border_size), PROPERTY_VEC2I},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"text", WIDGET(edit_box.text), PROPERTY_STRING},
+	{"orientation", WIDGET(edit_box.orientation), PROPERTY_ORIENTATION}
+};
+
+static struct property const list_box_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"background", WIDGET(list_box.background), PROPERTY_STRING},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"orientation", WIDGET(list_box.orientation), PROPERTY_ORIENTATION},
+	{"spacing", WIDGET(list_box.spacing), PROPERTY_INT},
+	{"scrollbartype", WIDGET(list_box.scrollbar_type), PROPERTY_STRING},
+	{"bordersize", WIDGET(list_box.border_size), PROPERTY_VEC2I},
+	{"priority", WIDGET(list_box.priority), PROPERTY_INT},
+	{"step", WIDGET(list_box.step), PROPERTY_INT},
+	{"horizontal", WIDGET(list_box.horizontal), PROPERTY_BOOL},
+	{"offset", WIDGET(list_box.offset), PROPERTY_VEC2I},
+	{"allwaystransparent", WIDGET(list_box.always_transparent), PROPERTY_BOOL}
+};
+
+static struct property const eu3_dialog_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"background", WIDGET(eu3_dialog.background), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"size", WIDGET(size), PROPERTY_VEC2I},
+	{"moveable", WIDGET(eu3_dialog.movable), PROPERTY_BOOL},
+	{"dontrender", WIDGET(eu3_dialog.dont_render), PROPERTY_STRING},
+	{"horizontalborder", WIDGET(eu3_dialog.horizontal_border), PROPERTY_STRING},
+	{"verticalborder", WIDGET(eu3_dialog.vertical_border), PROPERTY_STRING},
+	{"fullscreen", WIDGET(eu3_dialog.full_screen), PROPERTY_BOOL},
+	{"orientation", WIDGET(eu3_dialog.orientation), PROPERTY_ORIENTATION}
+};
+
+static struct property const shield_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"spritetype", WIDGET(shield.sprite_type), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I},
+	{"rotation", WIDGET(shield.rotation), PROPERTY_FLOAT}
+};
+
+static struct property const position_properties[] = {
+	{"name", WIDGET(name), PROPERTY_STRING},
+	{"position", WIDGET(position), PROPERTY_VEC2I}
+};
+
+static struct schema widget_schemas[] = {
+	{"windowtype", "window", TYPE_WINDOW,
+	 PROPERTIES(window_properties), NULL, true, WIDGET(window.children)},
+	{"icontype", "icon", TYPE_ICON,
+	 PROPERTIES(icon_properties), NULL, false, 0},
+	{"guibuttontype", "button", TYPE_BUTTON,
+	 PROPERTIES(button_properties), NULL, false, 0},
+	{"textboxtype", "text box", TYPE_TEXT_BOX,
+	 PROPERTIES(text_box_properties), NULL, false, 0},
+	{"instanttextboxtype", "instant text box", TYPE_INSTANT_TEXT_BOX,
+	 PROPERTIES(instant_text_box_properties), NULL, false, 0},
+	{"overlappingelementsboxtype", "overlapping elements box", TYPE_OVERLAPPING_ELEMENTS_BOX,
+	 PROPERTIES(overlapping_elements_box_properties), NULL, false, 0},
+	{"scrollbartype", "scrollbar", TYPE_SCROLLBAR,
+	 PROPERTIES(scrollbar_properties), NULL, true, WIDGET(scrollbar.children)},
+	{"checkboxtype", "checkbox", TYPE_CHECKBOX,
+	 PROPERTIES(checkbox_properties), NULL, false, 0},
+	{"editboxtype", "edit box", TYPE_EDIT_BOX,
+	 PROPERTIES(edit_box_properties), NULL, false, 0},
+	{"listboxtype", "list box", TYPE_LIST_BOX,
+	 PROPERTIES(list_box_properties), NULL, false, 0},
+	{"eu3dialogtype", "eu3 dialog", TYPE_EU3_DIALOG,
+	 PROPERTIES(eu3_dialog_properties), NULL, true, WIDGET(eu3_dialog.children)},
+	{"shieldtype", "shield", TYPE_SHIELD,
+	 PROPERTIES(shield_properties), NULL, false, 0},
+	{"positiontype", "position", TYPE_POSITION,
+	 PROPERTIES(position_properties), NULL, false, 0}
+};
+
+static struct schema_set widget_types = {PROPERTIES(widget_schemas)};
+
+static void parse_widget(struct source* src, char const* name, struct builder* widgets) {
+	struct schema const* schema = find_schema(&widget_types, name);
+	struct ui_widget* widget;
+	if (schema == NULL) {
+		syntax_error(src, "Unknown gui type_name '%s'.", name);
+	}
+	widget = push_item(widgets);
+	widget->type = schema->type;
+	parse_properties(src, schema, widget);
 }
 
-static void parse_bitmap_font(struct source* src, struct bitmap_font** fonts) {
-	struct bitmap_font* font = calloc_or_die(1, sizeof(struct bitmap_font));
+static void parse_widgets(struct source* src, struct builder* widgets) {
 	char c = '\0';
-	font->name = NULL;
-	font->font_name = NULL;
-	font->color = (struct rgba){0, 0, 0, 0};
-	font->effect = false;
-	font->color_codes = NULL;
-	font->next = NULL;
 	parse_str(src, "{");
 
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
+	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
+		char const* property = NULL;
 		parse_identifier(src, &property);
 		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &font->name);
-		} else if (strcasecmp(property, "fontname") == 0) {
-			parse_string_literal(src, &font->font_name);
-		} else if (strcasecmp(property, "color") == 0) {
-			parse_rgba_hex(src, &font->color);
-		} else if (strcasecmp(property, "effect") == 0) {
-			parse_bool_literal(src, &font->effect);
-		} else if (strcasecmp(property, "colorcodes") == 0) {
-			parse_color_codes(src, &font->color_codes);
-		} else {
-			error(src, "Unknown property '%s' for bitmap font.", property);
-		}
-		free(property);
-		peek_char(src, &c, true);
+		parse_widget(src, property, widgets);
 	}
 
 	parse_str(src, "}");
-
-	/* Add to the end of the list */
-	font->next = NULL;
-	if (*fonts == NULL) {
-		*fonts = font;
-	} else {
-		struct bitmap_font* last = *fonts;
-		while (last->next != NULL) {
-			last = last->next;
-		}
-		last->next = font;
-	}
 }
+/* endregion */
+
+/* region parse_bitmap_fonts */
+
+static struct property const bitmap_font_properties[] = {
+	{"name", offsetof(struct bitmap_font, name), PROPERTY_STRING},
+	{"fontname", offsetof(struct bitmap_font, font_name), PROPERTY_STRING},
+	{"color", offsetof(struct bitmap_font, color), PROPERTY_RGBA_HEX},
+	{"effect", offsetof(struct bitmap_font, effect), PROPERTY_BOOL},
+	{"colorcodes", offsetof(struct bitmap_font, color_codes), PROPERTY_COLOR_CODES}
+};
+
+static struct schema bitmap_font_schema = {
+	"bitmapfont", "bitmap font", 0,
+	PROPERTIES(bitmap_font_properties), NULL, false, 0
+};
 
-static void parse_bitmap_fonts(struct source* src, struct bitmap_font** fonts) {
+static void parse_bitmap_fonts(struct source* src, struct builder* fonts) {
 	char c = '\0';
 	parse_str(src, "{");
 
 	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
-		char* property = NULL;
 		parse_str(src, "bitmapfont");
 		parse_str(src, "=");
-		parse_bitmap_font(src, fonts);
-		free(property);
+		parse_properties(src, &bitmap_font_schema, push_item(fonts));
 	}
 
 	parse_str(src, "}");
@@ -1731,65 +1089,27 @@ static void parse_bitmap_fonts(struct source* src, struct bitmap_font** fonts) {
 
 /* region parse_fonts */
 
-static void parse_font(struct source* src, struct font** fonts) {
-	struct font* font = calloc_or_die(1, sizeof(struct font));
-	char c = '\0';
-	font->name = NULL;
-	font->font_name = NULL;
-	font->height = 0;
-	font->charset = NULL;
-	font->color = (struct rgba){0, 0, 0, 0};
-	font->next = NULL;
-
-	parse_str(src, "{");
-
-	peek_char(src, &c, true);
-	while (c != '}') {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		if (strcasecmp(property, "name") == 0) {
-			parse_string_literal(src, &font->name);
-		} else if (strcasecmp(property, "fontname") == 0) {
-			parse_string_literal(src, &font->font_name);
-		} else if (strcasecmp(property, "height") == 0) {
-			parse_int_literal(src, &font->height);
-		} else if (strcasecmp(property, "charset") == 0) {
-			parse_string_literal(src, &font->charset);
-		} else if (strcasecmp(property, "color") == 0) {
-			parse_rgba_hex(src, &font->color);
-		} else {
-			error(src, "Unknown property '%s' for font.", property);
-		}
-		free(property);
-		peek_char(src, &c, true);
-	}
-
-	parse_str(src, "}");
+static struct property const font_properties[] = {
+	{"name", offsetof(struct font, name), PROPERTY_STRING},
+	{"fontname", offsetof(struct font, font_name), PROPERTY_STRING},
+	{"height", offsetof(struct font, height), PROPERTY_INT},
+	{"charset", offsetof(struct font, charset), PROPERTY_STRING},
+	{"color", offsetof(struct font, color), PROPERTY_RGBA_HEX}
+};
 
-	/* Add to the end of the list */
-	font->next = NULL;
-	if (*fonts == NULL) {
-		*fonts = font;
-	} else {
-		struct font* last = *fonts;
-		while (last->next != NULL) {
-			last = last->next;
-		}
-		last->next = font;
-	}
-}
+static struct schema font_schema = {
+	"font", "font", 0,
+	PROPERTIES(font_properties), NULL, false, 0
+};
 
-static void parse_fonts(struct source* src, struct font** fonts) {
+static void parse_fonts(struct source* src, struct builder* fonts) {
 	char c = '\0';
 	parse_str(src, "{");
 
 	for (peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
-		char* property = NULL;
 		parse_str(src, "font");
 		parse_str(src, "=");
-		parse_font(src, fonts);
-		free(property);
+		parse_properties(src, &font_schema, push_item(fonts));
 	}
 
 	parse_str(src, "}");
@@ -1797,100 +1117,150 @@ static void parse_fonts(struct source* src, struct font** fonts) {
 
 /* endregion */
 
+/* The hashes are built on the first call to parse(), which may come from
+ * several threads at once. */
+static SDL_SpinLock schemas_lock = 0;
+static bool schemas_ready = false;
+
+static void init_schema(struct schema* schema) {
+	build_perfect_hash(&schema->hash, schema->properties,
+	                   schema->properties_count, sizeof(struct property));
+}
+
+static void init_schemas(void) {
+	size_t i;
+	SDL_AtomicLock(&schemas_lock);
+	if (!schemas_ready) {
+		for (i = 0; i < sprite_types.count; i++) {
+			init_schema(&sprite_types.schemas[i]);
+		}
+		build_perfect_hash(&sprite_types.hash, sprite_types.schemas,
+		                   sprite_types.count, sizeof(struct schema));
+		for (i = 0; i < widget_types.count; i++) {
+			init_schema(&widget_types.schemas[i]);
+		}
+		build_perfect_hash(&widget_types.hash, widget_types.schemas,
+		                   widget_types.count, sizeof(struct schema));
+		init_schema(&bitmap_font_schema);
+		init_schema(&font_schema);
+		schemas_ready = true;
+	}
+	SDL_AtomicUnlock(&schemas_lock);
+}
+
 static void ignore(struct source* src) {
 	/* TODO: Nothing should be ignored, remove this function when applicable. */
-	char c = '\0';
-	parse_str(src, "{");
-	for (c = peek_char(src, &c, true); c != '}'; peek_char(src, &c, true)) {
-		char* property = NULL;
-		parse_identifier(src, &property);
-		parse_str(src, "=");
-		peek_char(src, &c, true);
-		if (c == '{') {
-			if (strcasecmp(property, "color")  == 0
-			    || strcasecmp(property, "colortwo") == 0
-			    || strcasecmp(property, "offset2") == 0
-			    || strcasecmp(property, "diffuse") == 0
-			    || strcasecmp(property, "specular") == 0
-			    || strcasecmp(property, "ambient") == 0
-			    || strcasecmp(property, "direction") == 0
-			    || strcasecmp(property, "attenuation") == 0
-			    || strcasecmp(property, "position") == 0) {
-				while (c != '}') {
-					consume_char(src, &c, true);
-				}
-			} else {
-				ignore(src);
-			}
-		} else {
-			while (!is_whitespace(c)) {
-				consume_char(src, &c, false);
-				peek_char(src, &c, false);
-			}
-		}
-		free(property);
-		peek_char(src, &c, true);
+	struct script_reader reader;
+	struct script_token token;
+	init_script_reader(&reader, src);
+	if (!read_script_token(&reader, &token)) {
+		syntax_error(src, "Expected '{', but got EOF.");
 	}
-	parse_str(src, "}");
+	if (token.type != SCRIPT_BLOCK_OPEN) {
+		syntax_error(src, "Expected '{', but got '%.*s'.",
+		             (int) token.length, token.text);
+	}
+	skip_script_block(&reader);
 }
 
 void parse(
 	char const* path,
-	struct sprite** sprites,
-	struct ui_widget** widgets,
-	struct bitmap_font** bitmap_fonts,
-	struct font** fonts
+	struct arena* arena,
+	struct sprite_list* sprites,
+	struct ui_widget_list* widgets,
+	struct bitmap_font_list* bitmap_fonts,
+	struct font_list* fonts
 ) {
 	struct source src;
+	struct builder new_sprites, new_widgets, new_bitmap_fonts, new_fonts;
 	char c = '\0';
-	char* identifier = NULL;
-	src.loc.lineno = 1;
-	src.loc.colno = 1;
-	src.bufcap = 1;
-	src.buf = calloc_or_die(1, 1);
-	src.buflen = 0;
-	src.file = fopen(path, "r");
-	src.name = path;
-	if (src.file == NULL) {
-		fprintf(stderr, "Failed to open file '%s': %s\n", path,
-		        strerror(errno));
-		exit(EXIT_FAILURE);
-	}
+	char const* identifier = NULL;
+	init_builder(&new_sprites, sizeof(struct sprite));
+	init_builder(&new_widgets, sizeof(struct ui_widget));
+	init_builder(&new_bitmap_fonts, sizeof(struct bitmap_font));
+	init_builder(&new_fonts, sizeof(struct font));
+	init_schemas();
+	open_source(&src, path, arena);
 	while (peek_char(&src, &c , true)) {
 		parse_identifier(&src, &identifier);
 		parse_str(&src, "=");
 		if (strcasecmp(identifier, "spritetypes") == 0) {
-			parse_sprites(&src, sprites);
+			parse_sprites(&src, &new_sprites);
 		} else if (strcasecmp(identifier, "guitypes") == 0) {
-			parse_widgets(&src, widgets);
+			parse_widgets(&src, &new_widgets);
 		} else if (strcasecmp(identifier, "bitmapfonts") == 0) {
-			parse_bitmap_fonts(&src, bitmap_fonts);
+			parse_bitmap_fonts(&src, &new_bitmap_fonts);
 		} else if (strcasecmp(identifier, "fonts") == 0) {
-			parse_fonts(&src, fonts);
+			parse_fonts(&src, &new_fonts);
 		} else {
-			warning(&src, "Ignoring unknown type "
+			syntax_warning(&src, "Ignoring unknown type "
 			        "'%s'.", identifier);
 			ignore(&src);
 		}
 	}
-	fclose(src.file);
-	free(src.buf);
+
+	sprites->items = finish_items(&src, &new_sprites,
+	                              sprites->items, &sprites->count);
+	widgets->items = finish_items(&src, &new_widgets,
+	                              widgets->items, &widgets->count);
+	bitmap_fonts->items = finish_items(&src, &new_bitmap_fonts,
+	                                   bitmap_fonts->items, &bitmap_fonts->count);
+	fonts->items = finish_items(&src, &new_fonts, fonts->items, &fonts->count);
+	close_source(&src);
+}
+
+struct ui_widget_list ui_widget_children(struct ui_widget const* widget) {
+	switch (widget->type) {
+	case TYPE_WINDOW:
+		return widget->window.children;
+	case TYPE_SCROLLBAR:
+		return widget->scrollbar.children;
+	case TYPE_EU3_DIALOG:
+		return widget->eu3_dialog.children;
+	default:
+		return (struct ui_widget_list){NULL, 0};
+	}
+}
+
+static void visit_schema_strings(struct schema const* schema, void* def,
+                                 void (*visit)(char const** str, void* data), void* data) {
+	size_t i;
+	for (i = 0; i < schema->properties_count; i++) {
+		struct property const* property = &schema->properties[i];
+		if (property->kind == PROPERTY_STRING) {
+			visit((char const**) ((char*) def + property->offset), data);
+		}
+	}
+}
+
+static struct schema const* schema_of_type(struct schema_set const* set, int type) {
+	size_t i;
+	for (i = 0; i < set->count; i++) {
+		if (set->schemas[i].type == type) return &set->schemas[i];
+	}
+	return NULL;
 }
 
-void free_sprites(struct sprite* sprites) {
-	fprintf(stderr, "WARNING: free_sprites is not implemented.\n");
+void visit_sprite_strings(struct sprite* sprite,
+                          void (*visit)(char const** str, void* data), void* data) {
+	struct schema const* schema = schema_of_type(&sprite_types, sprite->type);
+	if (schema != NULL) visit_schema_strings(schema, sprite, visit, data);
 }
 
-void free_widgets(struct ui_widget* widgets) {
-	fprintf(stderr, "WARNING: free_widgets is not implemented.\n");
+void visit_widget_strings(struct ui_widget* widget,
+                          void (*visit)(char const** str, void* data), void* data) {
+	struct schema const* schema = schema_of_type(&widget_types, widget->type);
+	if (schema != NULL) visit_schema_strings(schema, widget, visit, data);
 }
 
-void free_bitmap_fonts(struct bitmap_font* bitmap_fonts) {
-	fprintf(stderr, "WARNING: free_bitmap_fonts is not implemented.\n");
+void visit_bitmap_font_strings(struct bitmap_font* font,
+                               void (*visit)(char const** str, void* data), void* data) {
+	visit_schema_strings(&bitmap_font_schema, font, visit, data);
 }
 
-void free_fonts(struct font* fonts) {
-	fprintf(stderr, "WARNING: free_fonts is not implemented.\n");
+void visit_font_strings(struct font* font,
+                        void (*visit)(char const** str, void* data), void* data) {
+	visit_schema_strings(&font_schema, font, visit, data);
 }
 
 /* region parse_font_desc */
@@ -1898,20 +1268,9 @@ void free_fonts(struct font* fonts) {
 void parse_font_desc(char const* path, struct font_desc* desc) {
 	struct source src;
 	char c = '\0';
-	char* identifier = NULL;
+	char const* identifier = NULL;
 	size_t i = 0;
-	src.loc.lineno = 1;
-	src.loc.colno = 1;
-	src.bufcap = 1;
-	src.buf = calloc_or_die(1, 1);
-	src.buflen = 0;
-	src.file = fopen(path, "r");
-	src.name = path;
-	if (src.file == NULL) {
-		fprintf(stderr, "Failed to open file '%s': %s\n", path,
-		        strerror(errno));
-		exit(EXIT_FAILURE);
-	}
+	open_source(&src, path, NULL);
 	parse_str(&src, "info");
 
 	parse_str(&src, "face=");
@@ -1978,7 +1337,7 @@ void parse_font_desc(char const* path, struct font_desc* desc) {
 			parse_str(&src, "id=");
 			parse_int_literal(&src, &id);
 			if (id < 0 || id > 255) {
-				error(&src, "id out of range 0-255.");
+				syntax_error(&src, "id out of range 0-255.");
 			}
 			desc->chars[id].id = id;
 			parse_str(&src, "x=");
@@ -1999,11 +1358,11 @@ void parse_font_desc(char const* path, struct font_desc* desc) {
 			parse_int_literal(&src, &desc->chars[id].page);
 		}
 	} else {
-		error(&src, "Unsupported charset '%s'.", desc->charset);
+		syntax_error(&src, "Unsupported charset '%s'.", desc->charset);
 	}
 
 	if (strcmp(identifier, "kernings") != 0) {
-		error(&src, "Expected kernings, but got '%s'.", identifier);
+		syntax_error(&src, "Expected kernings, but got '%s'.", identifier);
 	}
 	parse_str(&src, "count=");
 	parse_int_literal(&src, &desc->kernings_count);
@@ -2018,12 +1377,15 @@ void parse_font_desc(char const* path, struct font_desc* desc) {
 		parse_int_literal(&src, &desc->kernings[i].amount);
 	}
 
-	fclose(src.file);
-	free(src.buf);
+	close_source(&src);
 }
 
 void free_font_desc(struct font_desc* font_desc) {
-	fprintf(stderr, "free_font_desc not implemented\n");
+	free(font_desc->chars);
+	free(font_desc->kernings);
+	font_desc->chars = NULL;
+	font_desc->kernings = NULL;
+	font_desc->kernings_count = 0;
 }
 
-/* endregion */
\ No newline at end of file
+/* endregion */
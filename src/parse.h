@@ -1,8 +1,10 @@
 #ifndef OV2_PARSE_H
 #define OV2_PARSE_H
 
+#include "arena.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 struct rgb {
 	double r;
@@ -37,8 +39,8 @@ enum sprite_load_type {
 };
 
 struct simple_sprite {
-	char* texture_file;
-	char* effect_file;
+	char const* texture_file;
+	char const* effect_file;
 	int64_t no_of_frames;
 	bool always_transparent;
 	bool transparency_check;
@@ -54,9 +56,9 @@ struct line_chart {
 };
 
 struct masked_shield {
-	char* texture_file1;
-	char* texture_file2;
-	char* effect_file;
+	char const* texture_file1;
+	char const* texture_file2;
+	char const* effect_file;
 	bool always_transparent;
 	bool flipv;
 };
@@ -64,10 +66,10 @@ struct masked_shield {
 struct progress_bar {
 	struct rgb color1;
 	struct rgb color2;
-	char* texture_file_1;
-	char* texture_file_2;
+	char const* texture_file_1;
+	char const* texture_file_2;
 	struct vec2i size;
-	char* effect_file;
+	char const* effect_file;
 	bool always_transparent;
 	bool horizontal;
 	enum sprite_load_type load_type;
@@ -75,16 +77,16 @@ struct progress_bar {
 
 struct cornered_tile_sprite {
 	struct vec2i size;
-	char* texture_file;
+	char const* texture_file;
 	struct vec2i border_size;
 	enum sprite_load_type load_type;
 	bool always_transparent;
 };
 
 struct text_sprite {
-	char* texture_file;
+	char const* texture_file;
 	int64_t no_of_frames;
-	char* effect_file;
+	char const* effect_file;
 	bool no_refcount;
 	enum sprite_load_type load_type;
 	enum click_sound click_sound;
@@ -99,23 +101,23 @@ struct pie_chart {
 };
 
 struct tile_sprite {
-	char* texture_file;
-	char* effect_file;
+	char const* texture_file;
+	char const* effect_file;
 	enum sprite_load_type load_type;
 	bool no_refcount;
 	struct vec2i size;
 };
 
 struct scrolling_sprite {
-	char* texture_file1;
+	char const* texture_file1;
 	struct vec2i size;
-	char* effect_file;
+	char const* effect_file;
 	int64_t step;
 	bool always_transparent;
 };
 
 struct sprite {
-	char* name;
+	char const* name;
 	enum {
 		TYPE_SIMPLE_SPRITE,
 		TYPE_LINE_CHART,
@@ -140,7 +142,11 @@ struct sprite {
 		struct tile_sprite tile_sprite;
 		struct scrolling_sprite scrolling_sprite;
 	};
-	struct sprite* next;
+};
+
+struct sprite_list {
+	struct sprite* items;
+	size_t count;
 };
 
 /* endregion */
@@ -149,6 +155,12 @@ struct sprite {
 
 struct ui_widget;
 
+/* Widgets are stored contiguously, children included. */
+struct ui_widget_list {
+	struct ui_widget* items;
+	size_t count;
+};
+
 enum ui_orientation {
 	UI_ORIENTATION_LOWER_LEFT,
 	UI_ORIENTATION_UPPER_LEFT,
@@ -167,65 +179,65 @@ enum ui_format {
 };
 
 struct ui_window {
-	char* background;
+	char const* background;
 	bool movable;
-	char* dont_render;
-	char* horizontal_border;
-	char* vertical_border;
+	char const* dont_render;
+	char const* horizontal_border;
+	char const* vertical_border;
 	bool full_screen;
-	struct ui_widget* children;
+	struct ui_widget_list children;
 	enum ui_orientation orientation;
-	char* up_sound;
-	char* down_sound;
+	char const* up_sound;
+	char const* down_sound;
 };
 
 struct ui_icon {
-	char* sprite;
+	char const* sprite;
 	enum ui_orientation orientation;
 	int64_t frame;
-	char* button_mesh;
+	char const* button_mesh;
 	double rotation;
 	double scale;
 };
 
 struct ui_button {
-	char* quad_texture_sprite;
-	char* button_text;
-	char* button_font;
-	char* shortcut;
+	char const* quad_texture_sprite;
+	char const* button_text;
+	char const* button_font;
+	char const* shortcut;
 	enum click_sound click_sound;
 	enum ui_orientation orientation;
-	char* tooltip;
-	char* tooltip_text;
-	char* delayed_tooltip_text;
-	char* sprite_type;
-	char* parent;
+	char const* tooltip;
+	char const* tooltip_text;
+	char const* delayed_tooltip_text;
+	char const* sprite_type;
+	char const* parent;
 	double rotation;
 	enum ui_format format;
 	int64_t frame;
 };
 
 struct ui_text_box {
-	char* font;
+	char const* font;
 	struct vec2i border_size;
-	char* text;
+	char const* text;
 	int64_t max_width;
 	int64_t max_height;
 	enum ui_format format;
 	bool fixed_size;
-	char* texture_file;
+	char const* texture_file;
 	enum ui_orientation orientation;
 };
 
 struct ui_instant_text_box {
-	char* font;
+	char const* font;
 	struct vec2i border_size;
-	char* text;
+	char const* text;
 	int64_t max_width;
 	int64_t max_height;
 	enum ui_format format;
 	bool fixed_size;
-	char* texture_file;
+	char const* texture_file;
 	enum ui_orientation orientation;
 	bool always_transparent;
 };
@@ -237,10 +249,10 @@ struct ui_overlapping_elements_box {
 };
 
 struct ui_scrollbar {
-	char* slider;
-	char* track;
-	char* left_button;
-	char* right_button;
+	char const* slider;
+	char const* track;
+	char const* left_button;
+	char const* right_button;
 	int64_t priority;
 	struct vec2i border_size;
 	double max_value;
@@ -251,36 +263,36 @@ struct ui_scrollbar {
 	bool use_range_limit;
 	double range_limit_min;
 	double range_limit_max;
-	char* range_limit_min_icon;
-	char* range_limit_max_icon;
+	char const* range_limit_min_icon;
+	char const* range_limit_max_icon;
 	bool lockable;
-	struct ui_widget* children;
+	struct ui_widget_list children;
 };
 
 struct ui_checkbox {
-	char* quad_texture_sprite;
-	char* tooltip;
-	char* tooltip_text;
-	char* delayed_tooltip_text;
-	char* button_text;
-	char* button_font;
+	char const* quad_texture_sprite;
+	char const* tooltip;
+	char const* tooltip_text;
+	char const* delayed_tooltip_text;
+	char const* button_text;
+	char const* button_font;
 	enum ui_orientation orientation;
-	char* shortcut;
+	char const* shortcut;
 };
 
 struct ui_edit_box {
-	char* texture_file;
-	char* font;
+	char const* texture_file;
+	char const* font;
 	struct vec2i border_size;
-	char* text;
+	char const* text;
 	enum ui_orientation orientation;
 };
 
 struct ui_list_box {
-	char* background;
+	char const* background;
 	enum ui_orientation orientation;
 	int64_t spacing;
-	char* scrollbar_type;
+	char const* scrollbar_type;
 	struct vec2i border_size;
 	int64_t priority;
 	int64_t step;
@@ -290,24 +302,23 @@ struct ui_list_box {
 };
 
 struct ui_eu3_dialog {
-	char* background;
+	char const* background;
 	bool movable;
-	char* dont_render;
-	char* horizontal_border;
-	char* vertical_border;
+	char const* dont_render;
+	char const* horizontal_border;
+	char const* vertical_border;
 	bool full_screen;
 	enum ui_orientation orientation;
-	struct ui_widget* children;
+	struct ui_widget_list children;
 };
 
 struct ui_shield {
-	char* sprite_type;
+	char const* sprite_type;
 	double rotation;
 };
 
 struct ui_widget {
-	struct ui_widget* next;
-	char* name;
+	char const* name;
 	struct vec2i position;
 	struct vec2i size;
 	enum {
@@ -345,19 +356,32 @@ struct ui_widget {
 
 /* region bitmap fonts */
 
-struct color_codes {
-	char* name;
+/* Starts a color code in a text, '§' in the Windows-1252 the game's files are
+ * written in. The code itself is the character that follows, '!' going back
+ * to the font's own color. */
+#define COLOR_CODE_MARKER '\xa7'
+
+struct color_code {
+	char const* name;
 	struct rgb rgb;
-	struct color_codes* next;
+};
+
+struct color_code_list {
+	struct color_code* items;
+	size_t count;
 };
 
 struct bitmap_font {
-	char* name;
-	char* font_name;
+	char const* name;
+	char const* font_name;
 	struct rgba color;
 	bool effect;
-	struct color_codes* color_codes;
-	struct bitmap_font* next;
+	struct color_code_list color_codes;
+};
+
+struct bitmap_font_list {
+	struct bitmap_font* items;
+	size_t count;
 };
 
 /* endregion */
@@ -365,12 +389,16 @@ struct bitmap_font {
 /* region fonts */
 
 struct font {
-	char* name;
-	char* font_name;
+	char const* name;
+	char const* font_name;
 	int64_t height;
-	char* charset;
+	char const* charset;
 	struct rgba color;
-	struct font* next;
+};
+
+struct font_list {
+	struct font* items;
+	size_t count;
 };
 
 /* endregion */
@@ -392,11 +420,11 @@ struct font_desc_kerning {
 };
 
 struct font_desc {
-	char* face;
+	char const* face;
 	int64_t size;
 	int64_t bold;
 	int64_t italic;
-	char* charset;
+	char const* charset;
 	int64_t stretch_h;
 	int64_t smooth;
 	int64_t aa;
@@ -414,21 +442,32 @@ struct font_desc {
 
 /* endregion */
 
+/* Appends the definitions in `path` to the given lists. Everything parsed,
+ * including the list storage, is allocated from `arena` and released together
+ * with it. */
 void parse(
 	char const* path,
-	struct sprite** sprites,
-	struct ui_widget** widgets,
-	struct bitmap_font** bitmap_fonts,
-	struct font** fonts
+	struct arena* arena,
+	struct sprite_list* sprites,
+	struct ui_widget_list* widgets,
+	struct bitmap_font_list* bitmap_fonts,
+	struct font_list* fonts
 );
 
-void free_sprites(struct sprite*);
-
-void free_widgets(struct ui_widget*);
-
-void free_bitmap_fonts(struct bitmap_font*);
-
-void free_fonts(struct font*);
+/* Returns the children of windows, scrollbars and eu3 dialogs, and an empty
+ * list for every other widget. */
+struct ui_widget_list ui_widget_children(struct ui_widget const* widget);
+
+/* Call `visit` with the address of every string field of a definition, except
+ * those of children and colour codes. */
+void visit_sprite_strings(struct sprite* sprite,
+                          void (*visit)(char const** str, void* data), void* data);
+void visit_widget_strings(struct ui_widget* widget,
+                          void (*visit)(char const** str, void* data), void* data);
+void visit_bitmap_font_strings(struct bitmap_font* font,
+                               void (*visit)(char const** str, void* data), void* data);
+void visit_font_strings(struct font* font,
+                        void (*visit)(char const** str, void* data), void* data);
 
 void parse_font_desc(char const* path, struct font_desc* font_desc);
 
@@ -1,65 +1,130 @@
 #include "province_definitions.h"
 #include "csv.h"
+#include "vfs.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
 
-void load_province_definitions(
-	struct province_definition** definitions,
-	size_t* count
-) {
-	struct csv_file* csv = csv_open("map/definition.csv");
-	*definitions = NULL;
-	*count = 0;
+static uint32_t pack_color(unsigned char r, unsigned char g, unsigned char b) {
+	return (uint32_t) r << 16 | (uint32_t) g << 8 | (uint32_t) b;
+}
+
+static size_t color_slot(uint32_t color, size_t capacity) {
+	/* Fibonacci hashing, the low bits of neighbouring colors are too alike
+	 * to be used as they are. */
+	return (size_t) ((color * 2654435769u) >> 8) & (capacity - 1);
+}
+
+/* Indexes the definitions; of two with the same color or id the first is
+ * kept. The color index is kept at most half full, and ids above
+ * PROVINCE_ID_MAX are only found by color. */
+static void build_indexes(struct arena* arena, struct province_table* table) {
+	size_t capacity = 16;
+	size_t i;
+	while (capacity < table->count * 2) capacity *= 2;
+	table->by_color = arena_alloc(arena, capacity * sizeof(struct province_color_slot));
+	table->color_capacity = capacity;
+	table->max_id = 0;
+	for (i = 0; i < table->count; i++) {
+		unsigned int id = table->items[i].id;
+		if (id > PROVINCE_ID_MAX) {
+			fprintf(stderr, "WARNING: Province id %u is above %u, "
+			                "it can not be looked up by id.\n", id, PROVINCE_ID_MAX);
+		} else if (id > table->max_id) {
+			table->max_id = id;
+		}
+	}
+	table->by_id = arena_alloc(arena, ((size_t) table->max_id + 1) * sizeof(uint32_t));
+
+	for (i = 0; i < table->count; i++) {
+		struct province_definition const* definition = &table->items[i];
+		uint32_t color = pack_color(definition->r, definition->g, definition->b);
+		size_t j = color_slot(color, capacity);
+		while (table->by_color[j].item != 0 && table->by_color[j].color != color) {
+			j = (j + 1) & (capacity - 1);
+		}
+		if (table->by_color[j].item == 0) {
+			table->by_color[j].color = color;
+			table->by_color[j].item = (uint32_t) i + 1;
+		} else {
+			fprintf(stderr, "WARNING: Province %u has the color of province %u.\n",
+			        definition->id, table->items[table->by_color[j].item - 1].id);
+		}
+		if (definition->id > PROVINCE_ID_MAX) continue;
+		if (table->by_id[definition->id] == 0) {
+			table->by_id[definition->id] = (uint32_t) i + 1;
+		} else {
+			fprintf(stderr, "WARNING: Province %u is defined more than once.\n",
+			        definition->id);
+		}
+	}
+}
+
+void load_province_definitions(struct arena* arena, struct province_table* table) {
+	char const* path = find_asset("map/definition.csv");
+	struct csv_file* csv = path == NULL ? NULL : csv_open(path);
+	memset(table, 0, sizeof(struct province_table));
 	if (csv == NULL) {
 		fprintf(stderr, "Failed to open map/definition.csv: %s\n", strerror(errno));
 		return;
 	}
-	if (!csv_read_line(csv)) {
-		fprintf(stderr, "Failed to read first line of map/definition.csv: %s\n", strerror(errno));
-	} else {
+	if (csv->row_count != 0) {
 		bool success = true;
-		while (csv_read_line(csv)) {
-			struct province_definition* new_definitions = reallocarray(*definitions, *count + 1, sizeof(struct province_definition));
-			if (new_definitions == NULL) {
-				fprintf(stderr, "Failed to allocate memory for province definitions: %s\n", strerror(errno));
-				success = false;
-				break;
-			}
-			*definitions = new_definitions;
-			(*count)++;
+		/* The first line names the columns. */
+		size_t row = csv->line_numbers[0] == 1 ? 1 : 0;
+		table->items = arena_alloc(arena, csv->row_count * sizeof(struct province_definition));
+		for (; row < csv->row_count; row++) {
+			struct province_definition* definition = &table->items[table->count];
 			if (
-				!csv_read_uint(csv, &(*definitions)[*count - 1].id)
-				|| !csv_read_uchar(csv, &(*definitions)[*count - 1].r)
-				|| !csv_read_uchar(csv, &(*definitions)[*count - 1].g)
-				|| !csv_read_uchar(csv, &(*definitions)[*count - 1].b)
-				|| !csv_read_string(csv, &(*definitions)[*count - 1].name)
+				!csv_get_uint(csv, row, 0, &definition->id)
+				|| !csv_get_uchar(csv, row, 1, &definition->r)
+				|| !csv_get_uchar(csv, row, 2, &definition->g)
+				|| !csv_get_uchar(csv, row, 3, &definition->b)
+				|| !csv_get_string(csv, row, 4, arena, &definition->name)
 			) {
 				fprintf(stderr, "Failed to read 'map/definition.csv'.");
 				success = false;
 				break;
 			}
+			table->count++;
 		}
-		if (!success) {
-			if (*definitions != NULL) {
-				free_province_definitions(*definitions, *count);
-				*definitions = NULL;
-			}
-			*count = 0;
+		/* An empty table is what failure looks like to the caller. */
+		if (!success || table->count == 0 || table->count >= UINT32_MAX) {
+			memset(table, 0, sizeof(struct province_table));
+		} else {
+			build_indexes(arena, table);
 		}
 	}
 	csv_close(csv);
 }
 
-void free_province_definitions(
-	struct province_definition* definitions,
-	size_t count
+struct province_definition const* province_by_color(
+	struct province_table const* table,
+	unsigned char r,
+	unsigned char g,
+	unsigned char b
 ) {
+	uint32_t color = pack_color(r, g, b);
 	size_t i;
-	for (i = 0; i < count; i++) {
-		if (definitions[i].name != NULL) free(definitions[i].name);
+	if (table->color_capacity == 0) return NULL;
+	for (i = color_slot(color, table->color_capacity);
+	     table->by_color[i].item != 0;
+	     i = (i + 1) & (table->color_capacity - 1)) {
+		if (table->by_color[i].color == color) {
+			return &table->items[table->by_color[i].item - 1];
+		}
+	}
+	return NULL;
+}
+
+struct province_definition const* province_by_id(
+	struct province_table const* table,
+	unsigned int id
+) {
+	if (table->by_id == NULL || id > table->max_id || table->by_id[id] == 0) {
+		return NULL;
 	}
-	free(definitions);
-}
\ No newline at end of file
+	return &table->items[table->by_id[id] - 1];
+}
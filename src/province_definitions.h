@@ -1,6 +1,7 @@
 #ifndef OV2_PROVINCE_DEFINITIONS_H
 #define OV2_PROVINCE_DEFINITIONS_H
 
+#include "arena.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -13,15 +14,46 @@ struct province_definition {
     char* name;
 };
 
-/* Returns an empty list on failure */
-void load_province_definitions(
-	struct province_definition** definitions,
-	size_t* count
+/* The game keeps province ids in 16 bits; definitions with a larger id are
+ * left out of the id index. */
+#define PROVINCE_ID_MAX 65535u
+
+struct province_color_slot {
+	/* The color packed as 0xRRGGBB. */
+	uint32_t color;
+	/* Index of the definition plus one, 0 for an empty slot. */
+	uint32_t item;
+};
+
+/* Every province definition, indexed by color and by id. The color index uses
+ * open addressing with linear probing, `color_capacity` is a power of two.
+ * `by_id` holds the index of the definition of every id up to `max_id` plus
+ * one, 0 where there is none; `max_id` is at most PROVINCE_ID_MAX. */
+struct province_table {
+	struct province_definition* items;
+	size_t count;
+	struct province_color_slot* by_color;
+	size_t color_capacity;
+	uint32_t* by_id;
+	unsigned int max_id;
+};
+
+/* Returns an empty table on failure. The definitions, their names and the
+ * indexes are allocated from `arena`. */
+void load_province_definitions(struct arena* arena, struct province_table* table);
+
+/* Returns the definition of the province drawn in the color, or NULL. */
+struct province_definition const* province_by_color(
+	struct province_table const* table,
+	unsigned char r,
+	unsigned char g,
+	unsigned char b
 );
 
-void free_province_definitions(
-	struct province_definition* definitions,
-	size_t count
+/* Returns the definition of the province with the id, or NULL. */
+struct province_definition const* province_by_id(
+	struct province_table const* table,
+	unsigned int id
 );
 
 #endif /*OV2_PROVINCE_DEFINITIONS_H*/
@@ -0,0 +1,168 @@
+#include "province_geometry.h"
+#include "workers.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* What a worker adds up over its rows, `count` entries per share. */
+struct geometry_sums {
+	struct province_map const* map;
+	size_t count;
+	size_t shares_count;
+	uint32_t* min_x;
+	uint32_t* min_y;
+	uint32_t* max_x;
+	uint32_t* max_y;
+	uint64_t* sum_x;
+	uint64_t* sum_y;
+	uint32_t* pixels;
+};
+
+/* Pixels of the same province mostly come in runs along a row, which are
+ * added in one go. */
+static void sum_share(void* data, size_t index) {
+	struct geometry_sums const* sums = data;
+	struct province_map const* map = sums->map;
+	size_t base = index * sums->count;
+	uint32_t first = (uint32_t) ((uint64_t) map->height * index / sums->shares_count);
+	uint32_t end = (uint32_t) ((uint64_t) map->height * (index + 1) / sums->shares_count);
+	uint32_t* min_x = sums->min_x + base;
+	uint32_t* min_y = sums->min_y + base;
+	uint32_t* max_x = sums->max_x + base;
+	uint32_t* max_y = sums->max_y + base;
+	uint64_t* sum_x = sums->sum_x + base;
+	uint64_t* sum_y = sums->sum_y + base;
+	uint32_t* pixels = sums->pixels + base;
+	uint32_t x, y;
+	size_t i;
+	for (i = 0; i < sums->count; i++) {
+		min_x[i] = min_y[i] = UINT32_MAX;
+		max_x[i] = max_y[i] = 0;
+		sum_x[i] = sum_y[i] = 0;
+		pixels[i] = 0;
+	}
+	for (y = first; y < end; y++) {
+		uint16_t const* row = map->pixels + (size_t) y * map->width;
+		for (x = 0; x < map->width;) {
+			uint16_t province = row[x];
+			uint32_t start = x;
+			uint64_t length;
+			while (x < map->width && row[x] == province) x++;
+			if (province == PROVINCE_NONE || province >= sums->count) continue;
+			length = x - start;
+			if (start < min_x[province]) min_x[province] = start;
+			if (x - 1 > max_x[province]) max_x[province] = x - 1;
+			if (y < min_y[province]) min_y[province] = y;
+			if (y > max_y[province]) max_y[province] = y;
+			sum_x[province] += length * start + length * (length - 1) / 2;
+			sum_y[province] += length * y;
+			pixels[province] += (uint32_t) length;
+		}
+	}
+}
+
+/* The first share takes in the others. */
+static void merge_shares(struct geometry_sums* sums) {
+	size_t share, i;
+	for (share = 1; share < sums->shares_count; share++) {
+		size_t base = share * sums->count;
+		for (i = 0; i < sums->count; i++) {
+			if (sums->pixels[base + i] == 0) continue;
+			if (sums->min_x[base + i] < sums->min_x[i]) sums->min_x[i] = sums->min_x[base + i];
+			if (sums->min_y[base + i] < sums->min_y[i]) sums->min_y[i] = sums->min_y[base + i];
+			if (sums->max_x[base + i] > sums->max_x[i]) sums->max_x[i] = sums->max_x[base + i];
+			if (sums->max_y[base + i] > sums->max_y[i]) sums->max_y[i] = sums->max_y[base + i];
+			sums->sum_x[i] += sums->sum_x[base + i];
+			sums->sum_y[i] += sums->sum_y[base + i];
+			sums->pixels[i] += sums->pixels[base + i];
+		}
+	}
+}
+
+static void free_sums(struct geometry_sums* sums) {
+	free(sums->min_x);
+	free(sums->min_y);
+	free(sums->max_x);
+	free(sums->max_y);
+	free(sums->sum_x);
+	free(sums->sum_y);
+	free(sums->pixels);
+}
+
+bool build_province_geometry(
+	struct province_map const* map,
+	size_t provinces_count,
+	struct province_geometry* geometry
+) {
+	struct geometry_sums sums;
+	size_t size;
+	size_t i;
+	int cpu_count = SDL_GetCPUCount();
+
+	memset(geometry, 0, sizeof(struct province_geometry));
+	memset(&sums, 0, sizeof(struct geometry_sums));
+	sums.map = map;
+	sums.count = provinces_count;
+	/* One share per worker, each with its own sums so no two workers write
+	 * to the same place. */
+	sums.shares_count = cpu_count > 1 ? (size_t) cpu_count : 1;
+	if (sums.shares_count > map->height && map->height != 0) {
+		sums.shares_count = map->height;
+	}
+	size = sums.shares_count * provinces_count + 1;
+	sums.min_x = malloc(size * sizeof(uint32_t));
+	sums.min_y = malloc(size * sizeof(uint32_t));
+	sums.max_x = malloc(size * sizeof(uint32_t));
+	sums.max_y = malloc(size * sizeof(uint32_t));
+	sums.sum_x = malloc(size * sizeof(uint64_t));
+	sums.sum_y = malloc(size * sizeof(uint64_t));
+	sums.pixels = malloc(size * sizeof(uint32_t));
+	geometry->center_x = malloc((provinces_count + 1) * sizeof(float));
+	geometry->center_y = malloc((provinces_count + 1) * sizeof(float));
+	if (sums.min_x == NULL || sums.min_y == NULL || sums.max_x == NULL
+	    || sums.max_y == NULL || sums.sum_x == NULL || sums.sum_y == NULL
+	    || sums.pixels == NULL || geometry->center_x == NULL
+	    || geometry->center_y == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the province geometry: %s\n",
+		        strerror(errno));
+		free_sums(&sums);
+		free_province_geometry(geometry);
+		return false;
+	}
+
+	parallel_for(sums.shares_count, sum_share, &sums);
+	merge_shares(&sums);
+
+	for (i = 0; i < provinces_count; i++) {
+		if (sums.pixels[i] == 0) {
+			geometry->center_x[i] = 0.0f;
+			geometry->center_y[i] = 0.0f;
+		} else {
+			geometry->center_x[i] = (float) ((double) sums.sum_x[i] / sums.pixels[i] + 0.5);
+			geometry->center_y[i] = (float) ((double) sums.sum_y[i] / sums.pixels[i] + 0.5);
+		}
+	}
+	/* The first share of the bounds and counts is what is kept. */
+	geometry->count = provinces_count;
+	geometry->min_x = sums.min_x;
+	geometry->min_y = sums.min_y;
+	geometry->max_x = sums.max_x;
+	geometry->max_y = sums.max_y;
+	geometry->pixels = sums.pixels;
+	free(sums.sum_x);
+	free(sums.sum_y);
+	return true;
+}
+
+void free_province_geometry(struct province_geometry* geometry) {
+	free(geometry->min_x);
+	free(geometry->min_y);
+	free(geometry->max_x);
+	free(geometry->max_y);
+	free(geometry->center_x);
+	free(geometry->center_y);
+	free(geometry->pixels);
+	memset(geometry, 0, sizeof(struct province_geometry));
+}
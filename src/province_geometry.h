@@ -0,0 +1,36 @@
+#ifndef OV2_PROVINCE_GEOMETRY_H
+#define OV2_PROVINCE_GEOMETRY_H
+
+#include "province_map.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Where every province lies on the province map, one array per field indexed
+ * like the province table. Bounds are inclusive, in pixels from the top left;
+ * a province with no pixels has a min greater than its max and its center at
+ * 0, 0. */
+struct province_geometry {
+	size_t count;
+	uint32_t* min_x;
+	uint32_t* min_y;
+	uint32_t* max_x;
+	uint32_t* max_y;
+	/* The mean of the pixel centers. */
+	float* center_x;
+	float* center_y;
+	uint32_t* pixels;
+};
+
+/* Measures the `provinces_count` provinces of the map, each worker summing up
+ * a share of the rows on its own before the shares are added together.
+ * Returns false, with an empty table, on failure. */
+bool build_province_geometry(
+	struct province_map const* map,
+	size_t provinces_count,
+	struct province_geometry* geometry
+);
+
+void free_province_geometry(struct province_geometry* geometry);
+
+#endif /*OV2_PROVINCE_GEOMETRY_H*/
@@ -0,0 +1,82 @@
+#include "province_map.h"
+#include "workers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Rows scanned by one task. */
+#define BAND_HEIGHT 64
+
+struct map_scan {
+	struct province_table const* provinces;
+	unsigned char const* rgba;
+	struct province_map* map;
+};
+
+/* Neighbouring pixels are mostly of the same province, so a lookup is only
+ * made where the color changes. */
+static void scan_band(void* data, size_t index) {
+	struct map_scan const* scan = data;
+	uint32_t width = scan->map->width;
+	size_t first = index * BAND_HEIGHT * (size_t) width;
+	size_t end = first + BAND_HEIGHT * (size_t) width;
+	uint32_t last_color = 0xffffffffu;
+	uint16_t last_index = PROVINCE_NONE;
+	size_t i;
+	if (end > (size_t) width * scan->map->height) {
+		end = (size_t) width * scan->map->height;
+	}
+	for (i = first; i < end; i++) {
+		unsigned char const* pixel = scan->rgba + i * 4;
+		uint32_t color = (uint32_t) pixel[0] << 16 | (uint32_t) pixel[1] << 8 | pixel[2];
+		if (color != last_color) {
+			struct province_definition const* definition =
+				province_by_color(scan->provinces, pixel[0], pixel[1], pixel[2]);
+			last_color = color;
+			last_index = definition == NULL ? PROVINCE_NONE
+			             : (uint16_t) (definition - scan->provinces->items);
+		}
+		scan->map->pixels[i] = last_index;
+	}
+}
+
+bool build_province_map(
+	struct province_table const* provinces,
+	unsigned char const* rgba,
+	uint32_t width,
+	uint32_t height,
+	struct province_map* map
+) {
+	struct map_scan scan;
+	memset(map, 0, sizeof(struct province_map));
+	if (provinces->count >= PROVINCE_NONE) {
+		fprintf(stderr, "Too many provinces for the province map.\n");
+		return false;
+	}
+	map->pixels = malloc((size_t) width * height * sizeof(uint16_t) + 1);
+	if (map->pixels == NULL) {
+		fprintf(stderr, "Failed to allocate memory for the province map: %s\n",
+		        strerror(errno));
+		return false;
+	}
+	map->width = width;
+	map->height = height;
+	scan.provinces = provinces;
+	scan.rgba = rgba;
+	scan.map = map;
+	parallel_for((height + BAND_HEIGHT - 1) / BAND_HEIGHT, scan_band, &scan);
+	return true;
+}
+
+void free_province_map(struct province_map* map) {
+	free(map->pixels);
+	memset(map, 0, sizeof(struct province_map));
+}
+
+uint16_t province_at(struct province_map const* map, int32_t x, int32_t y) {
+	if (x < 0 || y < 0 || (uint32_t) x >= map->width || (uint32_t) y >= map->height) {
+		return PROVINCE_NONE;
+	}
+	return map->pixels[(size_t) y * map->width + (size_t) x];
+}
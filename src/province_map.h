@@ -0,0 +1,37 @@
+#ifndef OV2_PROVINCE_MAP_H
+#define OV2_PROVINCE_MAP_H
+
+#include "province_definitions.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* The index of a pixel whose color is not a province's. */
+#define PROVINCE_NONE 0xffff
+
+/* The index in the province table of the province at every pixel of the map,
+ * row by row from the top. */
+struct province_map {
+	uint32_t width;
+	uint32_t height;
+	uint16_t* pixels;
+};
+
+/* Maps the pixels of `rgba`, 4 bytes each, row by row from the top, to their
+ * provinces on the worker pool. Returns false, with an empty map, if there
+ * are too many provinces to index in 16 bits. */
+bool build_province_map(
+	struct province_table const* provinces,
+	unsigned char const* rgba,
+	uint32_t width,
+	uint32_t height,
+	struct province_map* map
+);
+
+void free_province_map(struct province_map* map);
+
+/* Returns the index of the province at the pixel, PROVINCE_NONE outside the
+ * map. */
+uint16_t province_at(struct province_map const* map, int32_t x, int32_t y);
+
+#endif /*OV2_PROVINCE_MAP_H*/
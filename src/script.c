@@ -0,0 +1,128 @@
+#include "script.h"
+#include <string.h>
+#include <ctype.h>
+
+/* How far the reader gets before releasing the part of the file behind it. */
+#define RELEASE_INTERVAL (4 * 1024 * 1024)
+
+void open_script(struct script_reader* reader, char const* path) {
+	open_source(&reader->own, path, NULL);
+	init_script_reader(reader, &reader->own);
+}
+
+void close_script(struct script_reader* reader) {
+	close_source(reader->src);
+	reader->src = NULL;
+}
+
+void init_script_reader(struct script_reader* reader, struct source* src) {
+	reader->src = src;
+	reader->depth = 0;
+	reader->released = src->file.data;
+}
+
+static bool is_word_end(char c) {
+	switch (c) {
+	case ' ': case '\t': case '\r': case '\n': case ';':
+	case '=': case '{': case '}': case '"': case '#':
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Keys and unquoted values are runs of anything but whitespace and the
+ * characters with a meaning of their own, so dates like 1836.1.1, paths and
+ * non-ASCII names all read as one token. */
+static void read_text(struct script_reader* reader, struct script_token* token) {
+	struct source* src = reader->src;
+	char const* end;
+	if (*src->cur == '"') {
+		advance_source(src, src->cur + 1);
+		end = memchr(src->cur, '"', (size_t) (src->end - src->cur));
+		if (end == NULL) {
+			syntax_error(src, "Expected '\"', but got EOF.");
+		}
+		token->text = src->cur;
+		token->length = (size_t) (end - src->cur);
+		token->quoted = true;
+		advance_source(src, end + 1);
+	} else {
+		end = src->cur;
+		while (end != src->end && !is_word_end(*end)) end++;
+		token->text = src->cur;
+		token->length = (size_t) (end - src->cur);
+		token->quoted = false;
+		advance_source(src, end);
+	}
+}
+
+bool read_script_token(struct script_reader* reader, struct script_token* token) {
+	struct source* src = reader->src;
+	char c;
+	token->text = NULL;
+	token->length = 0;
+	token->quoted = false;
+	if ((size_t) (src->cur - reader->released) >= RELEASE_INTERVAL) {
+		release_mapped_prefix(&src->file,
+		                      (size_t) (src->cur - src->file.data));
+		reader->released = src->cur;
+	}
+	if (!peek_char(src, &c, true)) {
+		if (reader->depth > 0) {
+			syntax_error(src, "Expected '}', but got EOF.");
+		}
+		token->type = SCRIPT_EOF;
+		token->loc = src->loc;
+		return false;
+	}
+	token->loc = src->loc;
+	switch (c) {
+	case '{':
+		consume_char(src, &c, false);
+		reader->depth += 1;
+		token->type = SCRIPT_BLOCK_OPEN;
+		break;
+	case '}':
+		if (reader->depth == 0) {
+			syntax_error(src, "Unexpected '}'.");
+		}
+		consume_char(src, &c, false);
+		reader->depth -= 1;
+		token->type = SCRIPT_BLOCK_CLOSE;
+		break;
+	case '=':
+		syntax_error(src, "Expected a key before '='.");
+		break;
+	default:
+		read_text(reader, token);
+		/* Whether the text is a key is only known once the '=' is seen,
+		 * the whitespace before it would be skipped next anyway. */
+		if (peek_char(src, &c, true) && c == '=') {
+			consume_char(src, &c, false);
+			token->type = SCRIPT_KEY;
+		} else {
+			token->type = SCRIPT_VALUE;
+		}
+		break;
+	}
+	return true;
+}
+
+void skip_script_block(struct script_reader* reader) {
+	struct script_token token;
+	size_t depth = reader->depth;
+	while (reader->depth >= depth && read_script_token(reader, &token));
+}
+
+bool script_token_is(struct script_token const* token, char const* str) {
+	size_t i;
+	for (i = 0; i < token->length; i++) {
+		if (str[i] == '\0'
+		    || tolower((unsigned char) token->text[i])
+		       != tolower((unsigned char) str[i])) {
+			return false;
+		}
+	}
+	return str[token->length] == '\0';
+}
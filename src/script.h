@@ -0,0 +1,65 @@
+#ifndef OV2_SCRIPT_H
+#define OV2_SCRIPT_H
+
+#include "lexer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Pull reader for Clausewitz script, the `key = value` and `key = { ... }`
+ * format of interface/, common/, history/ and events/ files and save games.
+ * Nothing is built or allocated while reading: tokens point into the mapped
+ * file and the reader only keeps its position and nesting depth. The pages
+ * behind the cursor are released as it goes, so files of any size can be
+ * streamed through it. */
+
+enum script_token_type {
+	SCRIPT_EOF,
+	/* A key followed by '=', which has been consumed. */
+	SCRIPT_KEY,
+	/* A value after '=' or an element of a list like `{ 1 2 3 }`. */
+	SCRIPT_VALUE,
+	SCRIPT_BLOCK_OPEN,
+	SCRIPT_BLOCK_CLOSE
+};
+
+struct script_token {
+	enum script_token_type type;
+	/* The key or value, without quotes. Not NUL-terminated, intern_n it
+	 * to keep it past close_script. */
+	char const* text;
+	size_t length;
+	bool quoted;
+	/* Where the token starts. */
+	struct loc loc;
+};
+
+struct script_reader {
+	struct source* src;
+	/* Blocks opened and not yet closed. */
+	size_t depth;
+	/* Where the file was last released up to. */
+	char const* released;
+	/* The source is owned by the reader if opened with open_script. */
+	struct source own;
+};
+
+/* Opens `path` for reading, exits the program if it can not be opened. */
+void open_script(struct script_reader* reader, char const* path);
+void close_script(struct script_reader* reader);
+
+/* Reads from an already open source, starting at its cursor at depth 0. */
+void init_script_reader(struct script_reader* reader, struct source* src);
+
+/* Reads the next token. Returns false, with the type set to SCRIPT_EOF, at the
+ * end of the file. Unbalanced braces and unterminated strings are syntax
+ * errors. */
+bool read_script_token(struct script_reader* reader, struct script_token* token);
+
+/* Skips the rest of the innermost open block, up to and including its '}', or
+ * the rest of the file outside of any block. */
+void skip_script_block(struct script_reader* reader);
+
+/* Compares the token text to a NUL-terminated string, ignoring case. */
+bool script_token_is(struct script_token const* token, char const* str);
+
+#endif /*OV2_SCRIPT_H*/
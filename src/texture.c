@@ -0,0 +1,342 @@
+#include "texture.h"
+#include "arena.h"
+#include "workers.h"
+#include "dds.h"
+#include "fs.h"
+#include "vfs.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#include <SOIL/SOIL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Open addressing with linear probing on the address of the path, `capacity`
+ * is a power of two and the table is kept at most half full. The textures
+ * themselves live in `storage` so that they never move. Only the thread
+ * owning the GL context uses these. */
+static struct texture** table = NULL;
+static size_t table_capacity = 0;
+static size_t table_count = 0;
+static struct arena storage;
+
+static size_t path_slot(char const* path, size_t capacity) {
+	/* Fibonacci hashing, the low bits of an address are mostly alignment. */
+	return (size_t) (((uint64_t) (uintptr_t) path * UINT64_C(11400714819323198485)) >> 32)
+	       & (capacity - 1);
+}
+
+static void grow_table(void) {
+	size_t new_capacity = table_capacity == 0 ? 256 : table_capacity * 2;
+	struct texture** new_table = calloc(new_capacity, sizeof(struct texture*));
+	size_t i;
+	if (new_table == NULL) {
+		fprintf(stderr, "Failed to allocate texture table: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < table_capacity; i++) {
+		if (table[i] != NULL) {
+			size_t j = path_slot(table[i]->path, new_capacity);
+			while (new_table[j] != NULL) {
+				j = (j + 1) & (new_capacity - 1);
+			}
+			new_table[j] = table[i];
+		}
+	}
+	free(table);
+	table = new_table;
+	table_capacity = new_capacity;
+}
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+/* glCompressedTexImage2D, when DXT blocks can be handed to GL as they are.
+ * Looked up on the thread owning the GL context before the first image is
+ * queued, read by the decoding threads. Setting OV2_NO_S3TC in the
+ * environment turns it off, to try the software decoder on drivers that
+ * have the extension. */
+static bool compression_checked = false;
+static PFNGLCOMPRESSEDTEXIMAGE2DPROC compressed_tex_image_2d = NULL;
+
+static void check_compression(void) {
+	compression_checked = true;
+	if (getenv("OV2_NO_S3TC") == NULL
+	    && SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc")) {
+		compressed_tex_image_2d = (PFNGLCOMPRESSEDTEXIMAGE2DPROC)
+			SDL_GL_GetProcAddress("glCompressedTexImage2D");
+	}
+	if (compressed_tex_image_2d == NULL) {
+		fprintf(stderr, "WARNING: Compressed textures are not supported, "
+		                "DDS files are decoded in software.\n");
+	}
+}
+
+/* An image decoded off the main thread from `file`, for upload_textures.
+ * Only the thread owning the GL context touches the texture itself. `pixels`
+ * holds DXT blocks if `compressed_format` is set, and was allocated by SOIL
+ * if `from_soil` is. If it could not be decoded `pixels` is NULL and `error`
+ * says why, to be reported on the main thread. */
+struct decoded_image {
+	struct texture* texture;
+	char const* file;
+	unsigned char* pixels;
+	int width;
+	int height;
+	GLenum compressed_format;
+	size_t compressed_size;
+	bool from_soil;
+	char const* error;
+	struct decoded_image* next;
+};
+
+static void free_pixels(struct decoded_image* image) {
+	if (image->pixels == NULL) return;
+	if (image->from_soil) {
+		SOIL_free_image_data(image->pixels);
+	} else {
+		free(image->pixels);
+	}
+	image->pixels = NULL;
+}
+
+/* DXT files are read here, kept compressed where GL takes them so and
+ * decoded otherwise; everything else is left to SOIL. SOIL_last_result is
+ * one global for every thread loading images, so it is not read: `error` only
+ * says which of the two failed. */
+static void read_image(char const* path, struct decoded_image* image) {
+	static GLenum const formats[] = {
+		GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+		GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
+		GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	};
+	struct dds_image dds;
+	int channels;
+	image->compressed_format = 0;
+	image->from_soil = false;
+	if (has_ext(path, ".dds") && read_dds(path, &dds)) {
+		image->width = (int) dds.width;
+		image->height = (int) dds.height;
+		if (compressed_tex_image_2d != NULL) {
+			image->pixels = dds.blocks;
+			image->compressed_format = formats[dds.format];
+			image->compressed_size = dds.size;
+			return;
+		}
+		image->pixels = malloc((size_t) dds.width * dds.height * 4);
+		if (image->pixels != NULL) {
+			decode_dds(&dds, image->pixels);
+		} else {
+			image->error = "out of memory decoding the DDS file";
+		}
+		free_dds(&dds);
+		return;
+	}
+	image->from_soil = true;
+	image->pixels = SOIL_load_image(path, &image->width, &image->height,
+	                                &channels, SOIL_LOAD_RGBA);
+	if (image->pixels == NULL) {
+		image->error = has_ext(path, ".dds")
+		               ? "not a DXT1, DXT3 or DXT5 DDS file, and SOIL can not read it"
+		               : "SOIL can not read it";
+	}
+}
+
+/* Hands the blocks to GL with the filtering and wrapping SOIL gives the
+ * textures it creates. */
+static GLuint create_compressed_texture(struct decoded_image const* image) {
+	GLuint id = 0;
+	bool failed;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	/* Errors left by earlier drawing are not this texture's. */
+	while (glGetError() != GL_NO_ERROR);
+	compressed_tex_image_2d(GL_TEXTURE_2D, 0, image->compressed_format,
+	                        image->width, image->height, 0,
+	                        (GLsizei) image->compressed_size, image->pixels);
+	failed = glGetError() != GL_NO_ERROR;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (failed) {
+		glDeleteTextures(1, &id);
+		return 0;
+	}
+	return id;
+}
+
+/* Decoded images waiting to be uploaded, oldest first, guarded by
+ * `decoded_lock`. */
+static SDL_SpinLock decoded_lock = 0;
+static struct decoded_image* decoded_head = NULL;
+static struct decoded_image* decoded_tail = NULL;
+
+static void decode_image(void* data) {
+	struct decoded_image* image = data;
+	read_image(image->file, image);
+
+	SDL_AtomicLock(&decoded_lock);
+	if (decoded_tail == NULL) {
+		decoded_head = image;
+	} else {
+		decoded_tail->next = image;
+	}
+	decoded_tail = image;
+	SDL_AtomicUnlock(&decoded_lock);
+}
+
+static struct decoded_image* pop_decoded_image(void) {
+	struct decoded_image* image;
+	SDL_AtomicLock(&decoded_lock);
+	image = decoded_head;
+	if (image != NULL) {
+		decoded_head = image->next;
+		if (decoded_head == NULL) decoded_tail = NULL;
+	}
+	SDL_AtomicUnlock(&decoded_lock);
+	return image;
+}
+
+struct texture const* find_or_load_texture(char const* path) {
+	struct texture* texture;
+	struct decoded_image* image;
+	char const* file;
+	size_t i;
+	if ((table_count + 1) * 2 > table_capacity) grow_table();
+	for (i = path_slot(path, table_capacity);
+	     table[i] != NULL;
+	     i = (i + 1) & (table_capacity - 1)) {
+		if (table[i]->path == path) return table[i];
+	}
+	texture = arena_alloc(&storage, sizeof(struct texture));
+	texture->path = path;
+	texture->state = TEXTURE_LOADING;
+	table[i] = texture;
+	table_count++;
+
+	if ((file = find_asset(path)) == NULL) {
+		fprintf(stderr, "Texture %s not found.\n", path);
+		texture->state = TEXTURE_FAILED;
+		return texture;
+	}
+	image = malloc(sizeof(struct decoded_image));
+	if (image == NULL) {
+		fprintf(stderr, "Failed to allocate memory for texture %s.\n", path);
+		texture->state = TEXTURE_FAILED;
+		return texture;
+	}
+	memset(image, 0, sizeof(struct decoded_image));
+	image->texture = texture;
+	image->file = file;
+	if (!compression_checked) check_compression();
+	/* Decoded right away if there are no background threads. */
+	if (!run_in_background(decode_image, image)) decode_image(image);
+	return texture;
+}
+
+void upload_textures(double seconds) {
+	uint64_t start = SDL_GetPerformanceCounter();
+	uint64_t budget = (uint64_t) (seconds * (double) SDL_GetPerformanceFrequency());
+	struct decoded_image* image;
+	while ((image = pop_decoded_image()) != NULL) {
+		struct texture* texture = image->texture;
+		if (image->pixels != NULL && image->compressed_format != 0) {
+			texture->id = create_compressed_texture(image);
+		} else if (image->pixels != NULL) {
+			texture->id = SOIL_create_OGL_texture(
+				image->pixels,
+				image->width,
+				image->height,
+				4,
+				SOIL_CREATE_NEW_ID,
+				0
+			);
+		}
+		if (texture->id != 0) {
+			texture->width = (int32_t) image->width;
+			texture->height = (int32_t) image->height;
+			texture->state = TEXTURE_LOADED;
+		} else {
+			if (image->pixels == NULL) {
+				fprintf(stderr, "Failed to load texture %s: %s.\n",
+				        image->file, image->error);
+			} else if (image->compressed_format != 0) {
+				fprintf(stderr, "Failed to create compressed texture %s.\n",
+				        texture->path);
+			} else {
+				fprintf(stderr, "Failed to create texture %s.\n", texture->path);
+			}
+			texture->state = TEXTURE_FAILED;
+		}
+		free_pixels(image);
+		free(image);
+		if (SDL_GetPerformanceCounter() - start >= budget) break;
+	}
+}
+
+struct frect texture_frame(int64_t frames_count, uint64_t frame) {
+	struct frect frame_rect = {0.0f, 0.0f, 1.0f, 1.0f};
+	if (frames_count > 1) {
+		frame_rect.w = 1.0f / (float) frames_count;
+		frame_rect.x = frame_rect.w * (float) frame;
+	}
+	return frame_rect;
+}
+
+void render_texture(
+	struct texture const* texture,
+	struct frect const* srcrect,
+	struct frect const* dstrect
+) {
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, texture->id);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBegin(GL_QUADS);
+
+	glTexCoord2f(srcrect->x, srcrect->y);
+	glVertex2f(dstrect->x, dstrect->y);
+
+	glTexCoord2f(srcrect->x + srcrect->w, srcrect->y);
+	glVertex2f(dstrect->x + dstrect->w, dstrect->y);
+
+	glTexCoord2f(srcrect->x + srcrect->w, srcrect->y + srcrect->h);
+	glVertex2f(dstrect->x + dstrect->w, dstrect->y + dstrect->h);
+
+	glTexCoord2f(srcrect->x, srcrect->y + srcrect->h);
+	glVertex2f(dstrect->x, dstrect->y + dstrect->h);
+
+	glEnd();
+	glDisable(GL_BLEND);
+	glDisable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void free_textures(void) {
+	size_t i;
+	struct decoded_image* image;
+	wait_for_background_tasks();
+	while ((image = pop_decoded_image()) != NULL) {
+		free_pixels(image);
+		free(image);
+	}
+	for (i = 0; i < table_capacity; i++) {
+		if (table[i] != NULL && table[i]->id != 0) {
+			glDeleteTextures(1, &table[i]->id);
+		}
+	}
+	free(table);
+	table = NULL;
+	table_capacity = 0;
+	table_count = 0;
+	arena_free(&storage);
+}
@@ -0,0 +1,55 @@
+#ifndef OV2_TEXTURE_H
+#define OV2_TEXTURE_H
+
+#include <GL/gl.h>
+#include <stdint.h>
+
+struct frect {
+	float x, y, w, h;
+};
+
+enum texture_state {
+	TEXTURE_LOADING,
+	TEXTURE_LOADED,
+	TEXTURE_FAILED
+};
+
+/* An image loaded the first time it is asked for and kept until
+ * free_textures. `id` is 0, and the size 0 by 0, until it is loaded, and for
+ * good if it could not be; it is not tried again. */
+struct texture {
+	char const* path;
+	enum texture_state state;
+	GLuint id;
+	int32_t width;
+	int32_t height;
+};
+
+/* Returns the texture of the image at `path`, which has to be interned: it is
+ * looked up by address. The file is found with find_asset, so the asset index
+ * has to be built first. The image is decoded on a background thread and only
+ * usable once upload_textures has handed it to GL, until then the texture is
+ * TEXTURE_LOADING and should not be drawn. Never returns NULL. */
+struct texture const* find_or_load_texture(char const* path);
+
+/* Creates the GL textures of the images decoded since the last call, until
+ * `seconds` have passed; at least one is created if any are waiting. Has to
+ * be called from the thread owning the GL context. */
+void upload_textures(double seconds);
+
+/* Returns the part of a texture holding `frame` of the `frames_count` frames
+ * laid out in it from left to right, in texture coordinates. */
+struct frect texture_frame(int64_t frames_count, uint64_t frame);
+
+/* Draws the `srcrect` part of the texture, in texture coordinates, over
+ * `dstrect`. */
+void render_texture(
+	struct texture const* texture,
+	struct frect const* srcrect,
+	struct frect const* dstrect
+);
+
+/* Waits for the images being decoded and deletes every texture. */
+void free_textures(void);
+
+#endif /*OV2_TEXTURE_H*/
@@ -1,11 +1,12 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
-#include <SOIL/SOIL.h>
 #include <SDL2/SDL_mouse.h>
 #include <SDL2/SDL_ttf.h>
 #include "ui.h"
 #include "bitmap_font.h"
+#include "texture.h"
+#include "intern.h"
 
 static char const* const month_names[] = {
 	"January",
@@ -22,143 +23,37 @@ static char const* const month_names[] = {
 	"December"
 };
 
-struct frect {
-	float x, y, w, h;
-};
-
-static struct ui_widget* find_widget(struct ui_widget* widgets, const char* name) {
-	for (; widgets != NULL; widgets = widgets->next) {
-		if (strcmp(widgets->name, name) == 0) {
-			return widgets;
+static struct ui_widget* find_widget(struct ui_widget_list widgets, const char* name) {
+	size_t i;
+	for (i = 0; i < widgets.count; i++) {
+		if (widgets.items[i].name == name) {
+			return &widgets.items[i];
 		}
 	}
 	return NULL;
 }
 
-static struct sprite* find_sprite(struct sprite* sprites, const char* name) {
-	for (; sprites != NULL; sprites = sprites->next) {
-		if (strcmp(sprites->name, name) == 0) {
-			return sprites;
+static struct sprite* find_sprite(struct sprite_list sprites, const char* name) {
+	size_t i;
+	for (i = 0; i < sprites.count; i++) {
+		if (sprites.items[i].name == name) {
+			return &sprites.items[i];
 		}
 	}
 	return NULL;
 }
 
-static struct bitmap_font* find_bitmap_font(struct bitmap_font* fonts, const char* name) {
-	for (; fonts != NULL; fonts = fonts->next) {
-		if (strcmp(fonts->name, name) == 0) {
-			return fonts;
+static struct bitmap_font* find_bitmap_font(struct bitmap_font_list fonts, const char* name) {
+	size_t i;
+	for (i = 0; i < fonts.count; i++) {
+		if (fonts.items[i].name == name) {
+			return &fonts.items[i];
 		}
 	}
 	return NULL;
 }
 
 /* region sprites */
-static void replace_backslashes_with_forward_slashes(char* c) {
-	for (; *c != '\0'; c++) {
-		if (*c == '\\') {
-			*c = '/';
-		}
-	}
-}
-
-static void replace_tga_extension_with_dds(char* c) {
-	for (; *c != '\0'; c++) {
-		if (*c == '.' && *(c + 1) == 't' && *(c + 2) == 'g' && *(c + 3) == 'a' && *(c + 4) == '\0') {
-			*(c + 1) = 'd';
-			*(c + 2) = 'd';
-			*(c + 3) = 's';
-		}
-	}
-}
-
-static GLuint load_texture(char const* path) {
-	GLuint id;
-	char* corrected_path = strdup(path);
-	replace_backslashes_with_forward_slashes(corrected_path);
-	if ((id = SOIL_load_OGL_texture(
-		corrected_path,
-		SOIL_LOAD_RGBA,
-		SOIL_CREATE_NEW_ID,
-		0
-	)) == 0) {
-		/* We retry with dds, as there are a lot of references to
-		 * non-existing tga files, with an existing dds counterpart. */
-		replace_tga_extension_with_dds(corrected_path);
-		if ((id = SOIL_load_OGL_texture(
-			corrected_path,
-			SOIL_LOAD_RGBA,
-			SOIL_CREATE_NEW_ID,
-			0
-		)) == 0) {
-			fprintf(stderr, "SOIL loading error while loading "
-				        "texture %s: %s\n", corrected_path,
-				SOIL_last_result());
-		}
-	}
-	free(corrected_path);
-	return id;
-}
-
-struct loaded_texture {
-	char const* name;
-	GLuint texture;
-	struct loaded_texture* next;
-};
-
-/* TODO: Let's not keep a global texture buffer like this. */
-static struct loaded_texture* loaded_textures = NULL;
-
-static GLuint find_texture(const char* name) {
-	struct loaded_texture* loaded_texture = loaded_textures;
-	for (; loaded_texture != NULL; loaded_texture = loaded_texture->next) {
-		if (strcmp(loaded_texture->name, name) == 0) {
-			return loaded_texture->texture;
-		}
-	}
-	return 0;
-}
-
-static GLuint find_or_load_texture(char const* name) {
-	GLuint texture = find_texture(name);
-	if (texture == 0 && (texture = load_texture(name), texture != 0)) {
-		struct loaded_texture* new_texture =
-			malloc(sizeof(struct loaded_texture));
-		new_texture->name = name;
-		new_texture->texture = texture;
-		new_texture->next = loaded_textures;
-		loaded_textures = new_texture;
-	}
-	return texture;
-}
-
-static void render_texture(
-	GLuint texture,
-	struct frect* srcrect,
-	struct frect* dstrect
-) {
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBegin(GL_QUADS);
-
-	glTexCoord2f(srcrect->x, srcrect->y);
-	glVertex2f(dstrect->x, dstrect->y);
-
-	glTexCoord2f(srcrect->x + srcrect->w, srcrect->y);
-	glVertex2f(dstrect->x + dstrect->w, dstrect->y);
-
-	glTexCoord2f(srcrect->x + srcrect->w, srcrect->y + srcrect->h);
-	glVertex2f(dstrect->x + dstrect->w, dstrect->y + dstrect->h);
-
-	glTexCoord2f(srcrect->x, srcrect->y + srcrect->h);
-	glVertex2f(dstrect->x, dstrect->y + dstrect->h);
-
-	glEnd();
-	glDisable(GL_BLEND);
-	glDisable(GL_TEXTURE_2D);
-}
 
 static void render_sprite(struct game_state const* state, struct sprite* sprite, uint64_t frame, struct frect* dstrect);
 static void render_simple_sprite(struct game_state const* state, struct sprite* sprite, uint64_t frame, struct frect* dstrect);
@@ -192,23 +87,12 @@ static void render_sprite(struct game_state const* state, struct sprite* sprite,
 }
 
 static void render_simple_sprite(struct game_state const* state, struct sprite* sprite, uint64_t frame, struct frect* dstrect) {
-	GLint width, height;
-	GLuint texture = find_or_load_texture(sprite->simple_sprite.texture_file);
-
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
-	dstrect->w = (float) width / (sprite->simple_sprite.no_of_frames > 1 ? (float) sprite->simple_sprite.no_of_frames : 1.0f);
-	if (dstrect->h == 0) dstrect->h = (float) height;
-	if (sprite->simple_sprite.no_of_frames > 1) {
-		float frame_width = 1.0f / (float)sprite->simple_sprite.no_of_frames;
-		float frame_x = frame_width * (float)frame;
-		struct frect srcrect = { frame_x, 0.0f, frame_width, 1.0f };
-		render_texture(texture, &srcrect, dstrect);
-	} else {
-		render_texture(texture, &(struct frect) { 0, 0, 1.0f, 1.0f }, dstrect);
-	}
-	glBindTexture(GL_TEXTURE_2D, 0);
+	struct texture const* texture = find_or_load_texture(sprite->simple_sprite.texture_file);
+	struct frect srcrect = texture_frame(sprite->simple_sprite.no_of_frames, frame);
+	if (texture->id == 0) return;
+	dstrect->w = (float) texture->width / (sprite->simple_sprite.no_of_frames > 1 ? (float) sprite->simple_sprite.no_of_frames : 1.0f);
+	if (dstrect->h == 0) dstrect->h = (float) texture->height;
+	render_texture(texture, &srcrect, dstrect);
 }
 
 /* endregion */
@@ -221,6 +105,30 @@ static void render_icon(struct game_state const* state, struct ui_widget* widget
 static void render_button(struct game_state const* state, struct ui_widget* widget, struct ui_widget* parent);
 static void render_text_box(struct game_state const* state, struct ui_widget* widget, struct ui_widget* parent);
 
+/* The names of the widgets looked up on every frame, interned on the first
+ * one so that finding them only compares pointers. */
+static struct {
+	char const* speed_indicator;
+	char const* date_text;
+	char const* menubar;
+	char const* chat_window;
+	char const* topbar;
+	char const* fps_counter;
+	char const* minimap_pic;
+} names;
+
+static void intern_names(void) {
+	if (names.speed_indicator != NULL) return;
+	names.speed_indicator = intern("speed_indicator");
+	names.date_text = intern("DateText");
+	names.menubar = intern("menubar");
+	names.chat_window = intern("chat_window");
+	names.topbar = intern("topbar");
+	names.fps_counter = intern("FPS_Counter");
+	names.minimap_pic = intern("minimap_pic");
+}
+
+/* `name` is interned. */
 static void find_and_render_widget(struct game_state const* state, char const* name) {
 	struct ui_widget* widget = find_widget(state->widgets, name);
 	if (widget == NULL) {
@@ -278,9 +186,9 @@ static void render_widget(struct game_state const* state, struct ui_widget* widg
 
 static void render_window(struct game_state const* state, struct ui_widget* widget, struct ui_widget* parent) {
 	if (widget->window.dont_render != NULL && *widget->window.dont_render != '\0') return; /* TODO: I just use this an internal hack to disable ui, but this should be implemented properly instead */
-	struct ui_widget* child = widget->window.children;
-	for (; child != NULL; child = child->next) {
-		render_widget(state, child, widget);
+	size_t i;
+	for (i = 0; i < widget->window.children.count; i++) {
+		render_widget(state, &widget->window.children.items[i], widget);
 	}
 }
 
@@ -336,14 +244,9 @@ static void render_button(struct game_state const* state, struct ui_widget* widg
 	} else {
 		/* region TODO: Figure out a proper way of handling no_of_frames/sprite texture size. */
 		if((widget->size.x == 0 || widget->size.y == 0) && sprite->type == TYPE_SIMPLE_SPRITE && sprite->simple_sprite.texture_file != NULL && *sprite->simple_sprite.texture_file != '\0') {
-			GLint width, height;
-			GLuint t = find_or_load_texture(sprite->simple_sprite.texture_file);
-			glBindTexture(GL_TEXTURE_2D, t);
-			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			widget->size.x = width;
-			widget->size.y = height;
+			struct texture const* texture = find_or_load_texture(sprite->simple_sprite.texture_file);
+			widget->size.x = texture->width;
+			widget->size.y = texture->height;
 			if (sprite->simple_sprite.no_of_frames > 1) {
 				widget->size.x /= (float) sprite->simple_sprite.no_of_frames;
 			}
@@ -432,14 +335,16 @@ static void render_text_box(struct game_state const* state, struct ui_widget* wi
 
 /* endregion */
 
-static struct ui_widget* find_window_child(struct ui_widget* widgets, const char* name) {
+static struct ui_widget* find_window_child(struct ui_widget_list widgets, const char* name) {
 	/* TODO: We really need a good way of just iterating every single ui widget i think */
-	for (; widgets != NULL; widgets = widgets->next) {
-		if (strcmp(widgets->name, name) == 0) {
-			return widgets;
+	size_t i;
+	for (i = 0; i < widgets.count; i++) {
+		struct ui_widget* widget = &widgets.items[i];
+		if (widget->name == name) {
+			return widget;
 		}
-		if (widgets->type == TYPE_WINDOW && widgets->window.children != NULL) {
-			struct ui_widget* child = find_widget(widgets->window.children, name);
+		if (widget->type == TYPE_WINDOW) {
+			struct ui_widget* child = find_widget(widget->window.children, name);
 			if (child != NULL) {
 				return child;
 			}
@@ -449,25 +354,46 @@ static struct ui_widget* find_window_child(struct ui_widget* widgets, const char
 }
 
 static void update_ui(struct game_state const* state) {
+	/* Widget strings are interned and never freed, so the date text points
+	 * into a buffer owned by this function instead. */
+	static char date[64];
+	static struct text_segment date_segments[8];
+	static struct text_template date_format = {
+		"$MONTH$ $DAY$, $YEAR$", date_segments, 0
+	};
+	char day[16];
+	char year[16];
+	struct text_parameter parameters[3];
+	struct localization const* month;
+	struct ui_widget* speed_indicator = find_window_child(state->widgets, names.speed_indicator);
+	struct ui_widget* date_text = find_window_child(state->widgets, names.date_text);
 	/*update ui*/
 	if (state->is_paused) {
-		find_window_child(state->widgets, "speed_indicator")->button.frame = 0;
+		speed_indicator->button.frame = 0;
 	} else {
-		find_window_child(state->widgets, "speed_indicator")->button.frame = state->speed;
+		speed_indicator->button.frame = state->speed;
 	}
 	/*print the date as Junary 24, 1836*/
-	char* date = malloc(32);
-	int32_t year = state->year;
-	int32_t month = state->month;
-	int32_t day = state->day;
-	sprintf(date, "%s %d, %d", month_names[month], day + 1, year + 1);
-	if (find_window_child(state->widgets, "DateText")->instant_text_box.text != NULL) {
-		free(find_window_child(state->widgets, "DateText")->instant_text_box.text);
+	if (date_format.count == 0) {
+		date_format.count = compile_text_template(date_format.text, date_segments);
 	}
-	find_window_child(state->widgets, "DateText")->instant_text_box.text = date;
+	month = localization_lookup(&state->localizations, month_names[state->month]);
+	sprintf(day, "%d", state->day + 1);
+	sprintf(year, "%d", state->year + 1);
+	parameters[0].name = "MONTH";
+	parameters[0].value = month != NULL
+	                      ? localization_text(&state->localizations, month)
+	                      : month_names[state->month];
+	parameters[1].name = "DAY";
+	parameters[1].value = day;
+	parameters[2].name = "YEAR";
+	parameters[2].value = year;
+	format_text(&date_format, parameters, 3, date, sizeof(date));
+	date_text->instant_text_box.text = date;
 }
 
 void render_ui(struct game_state const* state) {
+	intern_names();
 	update_ui(state);
 
 	/* Flat pixel-perfect rendering mode. */
@@ -482,22 +408,20 @@ void render_ui(struct game_state const* state) {
 
 	{
 		/* TODO: DEBUG Hide part of the menubar widget*/
-		struct ui_widget* widget = state->widgets;
-		for (; widget != NULL; widget = widget->next) {
-			if (strcmp(widget->name, "menubar") == 0) {
-				widget = widget->window.children;
-				for (; widget != NULL; widget = widget->next) {
-					if (strcmp(widget->name, "chat_window") == 0) {
-						widget->window.dont_render = "true";
-					}
+		struct ui_widget* menubar = find_widget(state->widgets, names.menubar);
+		if (menubar != NULL) {
+			struct ui_widget_list children = ui_widget_children(menubar);
+			size_t i;
+			for (i = 0; i < children.count; i++) {
+				if (children.items[i].name == names.chat_window) {
+					children.items[i].window.dont_render = "true";
 				}
-				break;
 			}
 		}
 	}
-	find_and_render_widget(state, "topbar");
-	find_and_render_widget(state, "FPS_Counter");
-	find_and_render_widget(state, "menubar");
-	find_and_render_widget(state, "minimap_pic");
+	find_and_render_widget(state, names.topbar);
+	find_and_render_widget(state, names.fps_counter);
+	find_and_render_widget(state, names.menubar);
+	find_and_render_widget(state, names.minimap_pic);
 	glPopMatrix();
 }
\ No newline at end of file
@@ -33,6 +33,15 @@ static bool handle_key_down(struct game_state* state, SDL_Keysym* keysym) {
 	case SDLK_KP_MINUS:
 		speed_down(state);
 		break;
+	case SDLK_l:
+		if (!set_language(state, (enum language) (
+			(state->localizations.language + 1) % LANGUAGE_COUNT
+		))) {
+			/* The current language is kept, unless the interface was
+			 * lost on the way. */
+			should_quit = state->should_quit;
+		}
+		break;
 	default:
 		break;
 	}
@@ -42,12 +51,14 @@ static bool handle_key_down(struct game_state* state, SDL_Keysym* keysym) {
 
 static void handle_mouse_button_down(struct game_state* state, SDL_MouseButtonEvent* button) {
 	/* TODO: Make this actually recursive. */
-	struct ui_widget* widget = NULL;
+	size_t i;
 	if (button->button != SDL_BUTTON_LEFT) return;
-	for (widget = state->widgets; widget != NULL; widget = widget->next) {
+	for (i = 0; i < state->widgets.count; i++) {
+		struct ui_widget* widget = &state->widgets.items[i];
 		if (widget->type == TYPE_WINDOW) {
-			struct ui_widget* child = NULL;
-			for (child = widget->window.children; child != NULL; child = child->next) {
+			size_t j;
+			for (j = 0; j < widget->window.children.count; j++) {
+				struct ui_widget* child = &widget->window.children.items[j];
 				if (child->type == TYPE_BUTTON) {
 					if (button->x >= child->position.x && button->x <= child->position.x + child->size.x &&
 					    button->y >= child->position.y && button->y <= child->position.y + child->size.y) {
@@ -66,12 +77,14 @@ static void handle_mouse_button_down(struct game_state* state, SDL_MouseButtonEv
 
 static void handle_mouse_button_up(struct game_state* state, SDL_MouseButtonEvent* button) {
 	/* TODO: Make this actually recursive. */
-	struct ui_widget* widget = NULL;
+	size_t i;
 	if (button->button != SDL_BUTTON_LEFT) return;
-	for (widget = state->widgets; widget != NULL; widget = widget->next) {
+	for (i = 0; i < state->widgets.count; i++) {
+		struct ui_widget* widget = &state->widgets.items[i];
 		if (widget->type == TYPE_WINDOW) {
-			struct ui_widget* child = NULL;
-			for (child = widget->window.children; child != NULL; child = child->next) {
+			size_t j;
+			for (j = 0; j < widget->window.children.count; j++) {
+				struct ui_widget* child = &widget->window.children.items[j];
 				if (child->type == TYPE_BUTTON) {
 					if (button->x >= child->position.x && button->x <= child->position.x + child->size.x &&
 					    button->y >= child->position.y && button->y <= child->position.y + child->size.y) {
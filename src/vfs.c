@@ -0,0 +1,277 @@
+#include "vfs.h"
+#include "arena.h"
+#include "fs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define ASSET_NAME_MAX 1024
+
+/* An entry of the tree, under its name from the top normalized as find_asset
+ * looks it up. An alias is a .dds file listed under its .tga name, which is
+ * not part of its directory and which a real .tga file replaces. */
+struct entry {
+	uint64_t hash;
+	char const* key;
+	bool is_alias;
+	bool is_listed;
+	struct asset asset;
+	/* Of a directory, what is in it: unordered while indexing, linked
+	 * through `sibling`, then `first` in name order. */
+	struct entry* children;
+	size_t children_count;
+	struct entry* sibling;
+	struct asset const* first;
+};
+
+/* Open addressing with linear probing on the hash of the key, `capacity` is a
+ * power of two and the table is kept at most half full. The entries, names
+ * and paths live in `storage`. */
+static struct entry** entries = NULL;
+static size_t entries_capacity = 0;
+static size_t entries_count = 0;
+static struct arena storage;
+
+/* Writes `name` as it is looked up into `key`. Returns false if it is too
+ * long. */
+static bool normalize_name(char const* name, char key[ASSET_NAME_MAX], size_t* length) {
+	*length = 0;
+	while (name[0] == '.' && (name[1] == '/' || name[1] == '\\')) {
+		name += 2;
+	}
+	for (; *name != '\0'; name++) {
+		char c = *name == '\\' ? '/' : (char) tolower((unsigned char) *name);
+		if (c == '/' && (*length == 0 || key[*length - 1] == '/')) continue;
+		if (*length + 1 == ASSET_NAME_MAX) return false;
+		key[(*length)++] = c;
+	}
+	if (*length != 0 && key[*length - 1] == '/') (*length)--;
+	key[*length] = '\0';
+	return true;
+}
+
+static void grow_entries(void) {
+	size_t new_capacity = entries_capacity == 0 ? 1024 : entries_capacity * 2;
+	struct entry** new_entries = calloc(new_capacity, sizeof(struct entry*));
+	size_t i;
+	if (new_entries == NULL) {
+		fprintf(stderr, "Failed to allocate asset index: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < entries_capacity; i++) {
+		if (entries[i] != NULL) {
+			size_t j = (size_t) entries[i]->hash & (new_capacity - 1);
+			while (new_entries[j] != NULL) {
+				j = (j + 1) & (new_capacity - 1);
+			}
+			new_entries[j] = entries[i];
+		}
+	}
+	free(entries);
+	entries = new_entries;
+	entries_capacity = new_capacity;
+}
+
+/* `key` is NUL-terminated. */
+static struct entry** find_slot(char const* key, uint64_t hash) {
+	size_t i;
+	for (i = (size_t) hash & (entries_capacity - 1);
+	     entries[i] != NULL;
+	     i = (i + 1) & (entries_capacity - 1)) {
+		if (entries[i]->hash == hash && strcmp(entries[i]->key, key) == 0) break;
+	}
+	return &entries[i];
+}
+
+/* Adds the file or directory to `parent`, or replaces the file of an earlier
+ * root; an alias only replaces another alias. Returns NULL if the name is
+ * taken by a directory where this is a file, or the other way around. */
+static struct entry* add_entry(char const* key, size_t length, struct entry* parent,
+                               char const* name, char const* path,
+                               bool is_directory, bool is_alias) {
+	uint64_t hash = hash_bytes(key, length);
+	struct entry** slot;
+	struct entry* entry;
+	if ((entries_count + 1) * 2 > entries_capacity) grow_entries();
+	slot = find_slot(key, hash);
+	if ((entry = *slot) == NULL) {
+		entry = arena_alloc(&storage, sizeof(struct entry));
+		entry->hash = hash;
+		entry->key = arena_strndup(&storage, key, length);
+		entry->asset.is_directory = is_directory;
+		*slot = entry;
+		entries_count++;
+	} else if (entry->asset.is_directory != is_directory) {
+		return NULL;
+	} else if (is_alias && !entry->is_alias) {
+		return entry;
+	}
+	entry->asset.name = name;
+	entry->asset.path = path;
+	entry->is_alias = is_alias;
+	if (!is_alias && !entry->is_listed && parent != NULL) {
+		entry->sibling = parent->children;
+		parent->children = entry;
+		parent->children_count++;
+		entry->is_listed = true;
+	}
+	return entry;
+}
+
+/* Adds what is in `directory` on disk to `parent`, whose key is the first
+ * `length` bytes of `key`. The keys of the entries are written after it. */
+static bool index_directory(char const* directory, struct entry* parent,
+                            char key[ASSET_NAME_MAX], size_t length) {
+	DIR* dir;
+	struct dirent* entry;
+	if ((dir = opendir(directory)) == NULL) return false;
+	while ((entry = readdir(dir)) != NULL) {
+		size_t name_length = strlen(entry->d_name);
+		size_t key_length = length + (length != 0) + name_length;
+		struct entry* child;
+		char* path;
+		bool is_directory;
+		size_t i;
+		if (entry->d_name[0] == '.') continue;
+		if (entry->d_type != DT_REG && entry->d_type != DT_DIR
+		    && entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN) {
+			continue;
+		}
+		/* The root itself is left out of the paths in the current
+		 * directory, as they were before there were roots. */
+		if (strcmp(directory, ".") == 0) {
+			path = arena_strndup(&storage, entry->d_name, name_length);
+		} else {
+			path = arena_alloc(&storage, strlen(directory) + 1 + name_length + 1);
+			strcpy(path, directory);
+			strcat(path, "/");
+			strcat(path, entry->d_name);
+		}
+		if (key_length + 1 >= ASSET_NAME_MAX) {
+			fprintf(stderr, "WARNING: Path too long, not indexed: %s\n", path);
+			continue;
+		}
+		/* Links, and everything on file systems that do not fill d_type,
+		 * are whatever they lead to. */
+		if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+			struct stat st;
+			if (stat(path, &st) != 0) {
+				fprintf(stderr, "WARNING: Failed to read %s, not indexed: %s\n",
+				        path, strerror(errno));
+				continue;
+			}
+			if (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode)) continue;
+			is_directory = S_ISDIR(st.st_mode);
+		} else {
+			is_directory = entry->d_type == DT_DIR;
+		}
+		if (length != 0) key[length] = '/';
+		for (i = 0; i < name_length; i++) {
+			key[key_length - name_length + i] = (char) tolower((unsigned char) entry->d_name[i]);
+		}
+		key[key_length] = '\0';
+		child = add_entry(key, key_length, parent, path + strlen(path) - name_length,
+		                  path, is_directory, false);
+		if (child == NULL) {
+			fprintf(stderr, "WARNING: %s is a file in one root and a directory in "
+			                "another, not indexed.\n", path);
+		} else if (is_directory) {
+			if (!index_directory(path, child, key, key_length)) {
+				fprintf(stderr, "WARNING: Failed to open directory %s: %s\n",
+				        path, strerror(errno));
+			}
+		} else if (has_ext(key, ".dds")) {
+			memcpy(key + key_length - 3, "tga", 3);
+			add_entry(key, key_length, parent, child->asset.name, path, false, true);
+		}
+	}
+	closedir(dir);
+	return true;
+}
+
+static int compare_names(void const* a, void const* b) {
+	return strcmp((*(struct entry* const*) a)->asset.name,
+	              (*(struct entry* const*) b)->asset.name);
+}
+
+/* Links what is in every directory in name order. */
+static void sort_directories(void) {
+	struct entry** sorted = NULL;
+	size_t capacity = 0;
+	size_t i, j;
+	for (i = 0; i < entries_capacity; i++) {
+		struct entry* directory = entries[i];
+		struct entry* child;
+		if (directory == NULL || directory->children_count == 0) continue;
+		if (directory->children_count > capacity) {
+			free(sorted);
+			capacity = directory->children_count;
+			if ((sorted = malloc(capacity * sizeof(struct entry*))) == NULL) {
+				fprintf(stderr, "Failed to allocate asset index: %s\n", strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+		}
+		for (j = 0, child = directory->children; child != NULL; child = child->sibling) {
+			sorted[j++] = child;
+		}
+		qsort(sorted, directory->children_count, sizeof(struct entry*), compare_names);
+		for (j = 0; j + 1 < directory->children_count; j++) {
+			sorted[j]->asset.next = &sorted[j + 1]->asset;
+		}
+		sorted[j]->asset.next = NULL;
+		directory->first = &sorted[0]->asset;
+	}
+	free(sorted);
+}
+
+bool index_assets(char const* const* roots, size_t roots_count) {
+	char key[ASSET_NAME_MAX];
+	struct entry* top;
+	size_t opened = 0;
+	size_t i;
+	free_asset_index();
+	key[0] = '\0';
+	top = add_entry(key, 0, NULL, "", ".", true, false);
+	for (i = 0; i < roots_count; i++) {
+		if (index_directory(roots[i], top, key, 0)) {
+			opened++;
+		} else {
+			fprintf(stderr, "WARNING: Failed to open directory %s: %s\n",
+			        roots[i], strerror(errno));
+		}
+	}
+	sort_directories();
+	return opened != 0;
+}
+
+static struct entry const* find_entry(char const* name) {
+	char key[ASSET_NAME_MAX];
+	size_t length;
+	if (entries_count == 0 || !normalize_name(name, key, &length)) return NULL;
+	return *find_slot(key, hash_bytes(key, length));
+}
+
+char const* find_asset(char const* name) {
+	struct entry const* entry = find_entry(name);
+	if (entry == NULL || entry->asset.is_directory) {
+		errno = ENOENT;
+		return NULL;
+	}
+	return entry->asset.path;
+}
+
+struct asset const* list_assets(char const* name) {
+	struct entry const* entry = find_entry(name);
+	return entry != NULL && entry->asset.is_directory ? entry->first : NULL;
+}
+
+void free_asset_index(void) {
+	free(entries);
+	entries = NULL;
+	entries_capacity = 0;
+	entries_count = 0;
+	arena_free(&storage);
+}
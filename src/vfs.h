@@ -0,0 +1,45 @@
+#ifndef OV2_VFS_H
+#define OV2_VFS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* The game's files are read from a list of roots, the game itself and then
+ * any mods, merged into one tree where a file in a later root hides the same
+ * file in the ones before. The tree is listed once at startup so that finding
+ * or listing files afterwards never goes to the disk.
+ *
+ * Files refer to each other by names like "GFX\\Interface\\button.tga",
+ * spelled differently from file to file and often naming a .tga that only
+ * exists as a .dds, so names are looked up ignoring case, and a .dds file
+ * can also be found by its name with .tga unless that file exists too. */
+
+/* A file or directory of the tree. `name` is spelled as on disk, and `path`
+ * is where the file is in the last root that has it. */
+struct asset {
+	char const* name;
+	char const* path;
+	bool is_directory;
+	/* The next entry of the same directory, in name order. */
+	struct asset const* next;
+};
+
+/* Lists every file under `roots`, recursively, skipping names that start
+ * with a '.'. Returns false if none of the roots could be opened. Builds the
+ * index anew if it was already built; not to be called while other threads
+ * use it. */
+bool index_assets(char const* const* roots, size_t roots_count);
+
+/* Returns the path of the file `name` refers to, relative to the roots, or
+ * NULL and sets errno if there is no such file. Case, a leading "./" and
+ * repeated separators do not matter, and '\\' is read as '/'. The path stays
+ * valid until free_asset_index. */
+char const* find_asset(char const* name);
+
+/* Returns the first entry of the directory `name`, "" being the top of the
+ * tree, or NULL if it is empty or there is no such directory. */
+struct asset const* list_assets(char const* name);
+
+void free_asset_index(void);
+
+#endif /*OV2_VFS_H*/
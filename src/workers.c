@@ -0,0 +1,187 @@
+#include "workers.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct work {
+	void (*task)(void* data, size_t index);
+	void* data;
+	size_t count;
+	SDL_atomic_t next;
+};
+
+static int run_tasks(void* ptr) {
+	struct work* work = ptr;
+	size_t i;
+	while ((i = (size_t) SDL_AtomicAdd(&work->next, 1)) < work->count) {
+		work->task(work->data, i);
+	}
+	return 0;
+}
+
+void parallel_for(size_t count, void (*task)(void* data, size_t index), void* data) {
+	struct work work;
+	SDL_Thread** threads = NULL;
+	size_t thread_count = (size_t) SDL_GetCPUCount();
+	size_t i;
+
+	work.task = task;
+	work.data = data;
+	work.count = count;
+	SDL_AtomicSet(&work.next, 0);
+
+	/* The calling thread works too, so it only needs count - 1 helpers. */
+	if (thread_count > count) thread_count = count;
+	if (thread_count > 1) {
+		threads = calloc(thread_count - 1, sizeof(SDL_Thread*));
+	}
+	if (threads != NULL) {
+		for (i = 0; i < thread_count - 1; i++) {
+			threads[i] = SDL_CreateThread(run_tasks, "worker", &work);
+			if (threads[i] == NULL) {
+				fprintf(stderr, "WARNING: Failed to create worker "
+				                "thread: %s\n", SDL_GetError());
+			}
+		}
+	}
+	run_tasks(&work);
+	if (threads != NULL) {
+		for (i = 0; i < thread_count - 1; i++) {
+			if (threads[i] != NULL) SDL_WaitThread(threads[i], NULL);
+		}
+		free(threads);
+	}
+}
+
+/* region background */
+
+struct background_task {
+	void (*task)(void* data);
+	void* data;
+	struct background_task* next;
+};
+
+/* The queue and the count of unfinished tasks are guarded by `queue_lock`.
+ * Threads are started with the first task and run until stopped. */
+static SDL_mutex* queue_lock = NULL;
+static SDL_cond* queue_changed = NULL;
+static SDL_cond* queue_done = NULL;
+static struct background_task* queue_head = NULL;
+static struct background_task* queue_tail = NULL;
+static size_t unfinished_tasks = 0;
+static bool stopping = false;
+static SDL_Thread** background_threads = NULL;
+static size_t background_thread_count = 0;
+
+static int run_background_tasks(void* ptr) {
+	(void) ptr;
+	SDL_LockMutex(queue_lock);
+	for (;;) {
+		struct background_task* task;
+		while (queue_head == NULL && !stopping) {
+			SDL_CondWait(queue_changed, queue_lock);
+		}
+		if (queue_head == NULL) break;
+		task = queue_head;
+		queue_head = task->next;
+		if (queue_head == NULL) queue_tail = NULL;
+		SDL_UnlockMutex(queue_lock);
+
+		task->task(task->data);
+		free(task);
+
+		SDL_LockMutex(queue_lock);
+		if (--unfinished_tasks == 0) SDL_CondBroadcast(queue_done);
+	}
+	SDL_UnlockMutex(queue_lock);
+	return 0;
+}
+
+/* One thread is left to the caller, the game renders while these work. */
+static bool start_background_workers(void) {
+	size_t thread_count = (size_t) SDL_GetCPUCount();
+	size_t i;
+	if (thread_count > 1) thread_count -= 1;
+	queue_lock = SDL_CreateMutex();
+	queue_changed = SDL_CreateCond();
+	queue_done = SDL_CreateCond();
+	background_threads = calloc(thread_count, sizeof(SDL_Thread*));
+	if (queue_lock == NULL || queue_changed == NULL || queue_done == NULL
+	    || background_threads == NULL) {
+		fprintf(stderr, "Failed to start background workers: %s\n", SDL_GetError());
+		stop_background_workers();
+		return false;
+	}
+	for (i = 0; i < thread_count; i++) {
+		SDL_Thread* thread = SDL_CreateThread(run_background_tasks, "background", NULL);
+		if (thread == NULL) {
+			fprintf(stderr, "WARNING: Failed to create background worker "
+			                "thread: %s\n", SDL_GetError());
+		} else {
+			background_threads[background_thread_count++] = thread;
+		}
+	}
+	if (background_thread_count == 0) {
+		stop_background_workers();
+		return false;
+	}
+	return true;
+}
+
+bool run_in_background(void (*task)(void* data), void* data) {
+	struct background_task* background_task;
+	if (background_threads == NULL && !start_background_workers()) return false;
+	if ((background_task = malloc(sizeof(struct background_task))) == NULL) {
+		fprintf(stderr, "Failed to allocate memory for background task.\n");
+		return false;
+	}
+	background_task->task = task;
+	background_task->data = data;
+	background_task->next = NULL;
+	SDL_LockMutex(queue_lock);
+	if (queue_tail == NULL) {
+		queue_head = background_task;
+	} else {
+		queue_tail->next = background_task;
+	}
+	queue_tail = background_task;
+	unfinished_tasks++;
+	SDL_CondSignal(queue_changed);
+	SDL_UnlockMutex(queue_lock);
+	return true;
+}
+
+void wait_for_background_tasks(void) {
+	if (queue_lock == NULL) return;
+	SDL_LockMutex(queue_lock);
+	while (unfinished_tasks != 0) {
+		SDL_CondWait(queue_done, queue_lock);
+	}
+	SDL_UnlockMutex(queue_lock);
+}
+
+void stop_background_workers(void) {
+	size_t i;
+	if (queue_lock != NULL && queue_changed != NULL && queue_done != NULL) {
+		wait_for_background_tasks();
+		SDL_LockMutex(queue_lock);
+		stopping = true;
+		SDL_CondBroadcast(queue_changed);
+		SDL_UnlockMutex(queue_lock);
+	}
+	for (i = 0; i < background_thread_count; i++) {
+		SDL_WaitThread(background_threads[i], NULL);
+	}
+	free(background_threads);
+	SDL_DestroyCond(queue_done);
+	SDL_DestroyCond(queue_changed);
+	SDL_DestroyMutex(queue_lock);
+	background_threads = NULL;
+	background_thread_count = 0;
+	queue_lock = NULL;
+	queue_changed = NULL;
+	queue_done = NULL;
+	stopping = false;
+}
+
+/* endregion */
@@ -0,0 +1,23 @@
+#ifndef OV2_WORKERS_H
+#define OV2_WORKERS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Calls `task(data, i)` for every `i` in [0, count) on a pool of worker
+ * threads, one index at a time, and returns once every task has finished.
+ * Tasks are picked up in order but may complete in any order. */
+void parallel_for(size_t count, void (*task)(void* data, size_t index), void* data);
+
+/* Queues `task(data)` to run on a pool of background threads and returns at
+ * once. Tasks are started in the order they are queued. Returns false if the
+ * pool can not be started, in which case the task is not run. */
+bool run_in_background(void (*task)(void* data), void* data);
+
+/* Returns once every task queued so far has finished. */
+void wait_for_background_tasks(void);
+
+/* Waits for the queued tasks and ends the background threads. */
+void stop_background_workers(void);
+
+#endif /*OV2_WORKERS_H*/